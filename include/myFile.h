@@ -0,0 +1 @@
+../src/util/myFile.h
\ No newline at end of file
@@ -0,0 +1 @@
+../src/util/myThread.h
\ No newline at end of file
@@ -1,31 +1,42 @@
 cirCmd.o: cirCmd.cpp cirMgr.h cirDef.h ../../include/myHashMap.h \
   ../../include/sat.h ../../include/Solver.h ../../include/SolverTypes.h \
   ../../include/Global.h ../../include/VarOrder.h ../../include/Heap.h \
-  ../../include/Proof.h ../../include/File.h cirGate.h cirCmd.h \
-  ../../include/cmdParser.h ../../include/cmdCharDef.h \
+  ../../include/Proof.h ../../include/File.h ../../include/myArena.h \
+  cirGate.h cirCmd.h ../../include/cmdParser.h ../../include/cmdCharDef.h \
   ../../include/util.h ../../include/rnGen.h ../../include/myUsage.h
 cirFraig.o: cirFraig.cpp cirMgr.h cirDef.h ../../include/myHashMap.h \
   ../../include/sat.h ../../include/Solver.h ../../include/SolverTypes.h \
   ../../include/Global.h ../../include/VarOrder.h ../../include/Heap.h \
-  ../../include/Proof.h ../../include/File.h cirGate.h \
-  ../../include/util.h ../../include/rnGen.h ../../include/myUsage.h
+  ../../include/Proof.h ../../include/File.h ../../include/myArena.h \
+  cirGate.h ../../include/util.h ../../include/rnGen.h \
+  ../../include/myUsage.h
 cirGate.o: cirGate.cpp cirGate.h cirDef.h ../../include/myHashMap.h \
   ../../include/sat.h ../../include/Solver.h ../../include/SolverTypes.h \
   ../../include/Global.h ../../include/VarOrder.h ../../include/Heap.h \
   ../../include/Proof.h ../../include/File.h cirMgr.h \
-  ../../include/util.h ../../include/rnGen.h ../../include/myUsage.h
+  ../../include/myArena.h ../../include/util.h ../../include/rnGen.h \
+  ../../include/myUsage.h
 cirMgr.o: cirMgr.cpp cirMgr.h cirDef.h ../../include/myHashMap.h \
   ../../include/sat.h ../../include/Solver.h ../../include/SolverTypes.h \
   ../../include/Global.h ../../include/VarOrder.h ../../include/Heap.h \
-  ../../include/Proof.h ../../include/File.h cirGate.h \
-  ../../include/util.h ../../include/rnGen.h ../../include/myUsage.h
+  ../../include/Proof.h ../../include/File.h ../../include/myArena.h \
+  cirGate.h ../../include/util.h ../../include/rnGen.h \
+  ../../include/myUsage.h ../../include/myFile.h ../../include/myThread.h
 cirOpt.o: cirOpt.cpp cirMgr.h cirDef.h ../../include/myHashMap.h \
   ../../include/sat.h ../../include/Solver.h ../../include/SolverTypes.h \
   ../../include/Global.h ../../include/VarOrder.h ../../include/Heap.h \
-  ../../include/Proof.h ../../include/File.h cirGate.h \
-  ../../include/util.h ../../include/rnGen.h ../../include/myUsage.h
+  ../../include/Proof.h ../../include/File.h ../../include/myArena.h \
+  cirGate.h ../../include/util.h ../../include/rnGen.h \
+  ../../include/myUsage.h
 cirSim.o: cirSim.cpp cirMgr.h cirDef.h ../../include/myHashMap.h \
   ../../include/sat.h ../../include/Solver.h ../../include/SolverTypes.h \
   ../../include/Global.h ../../include/VarOrder.h ../../include/Heap.h \
-  ../../include/Proof.h ../../include/File.h cirGate.h \
-  ../../include/util.h ../../include/rnGen.h ../../include/myUsage.h
+  ../../include/Proof.h ../../include/File.h ../../include/myArena.h \
+  cirGate.h ../../include/util.h ../../include/rnGen.h \
+  ../../include/myUsage.h ../../include/myThread.h ../../include/myFile.h
+cirSnap.o: cirSnap.cpp cirMgr.h cirDef.h ../../include/myHashMap.h \
+  ../../include/sat.h ../../include/Solver.h ../../include/SolverTypes.h \
+  ../../include/Global.h ../../include/VarOrder.h ../../include/Heap.h \
+  ../../include/Proof.h ../../include/File.h ../../include/myArena.h \
+  cirGate.h ../../include/myFile.h ../../include/util.h \
+  ../../include/rnGen.h ../../include/myUsage.h
@@ -6,6 +6,7 @@
   Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
 ****************************************************************************/
 
+#include <cstdlib>
 #include <cassert>
 #include <iostream>
 #include <iomanip>
@@ -27,10 +28,13 @@ initCirCmd()
          cmdMgr->regCmd("CIRGate", 4, new CirGateCmd) &&
          cmdMgr->regCmd("CIRSWeep", 5, new CirSweepCmd) &&
          cmdMgr->regCmd("CIROPTimize", 6, new CirOptCmd) &&
+         cmdMgr->regCmd("CIRCOMPact", 7, new CirCompactCmd) &&
          cmdMgr->regCmd("CIRSTRash", 6, new CirStrashCmd) &&
          cmdMgr->regCmd("CIRSIMulate", 6, new CirSimCmd) &&
          cmdMgr->regCmd("CIRFraig", 4, new CirFraigCmd) &&
-         cmdMgr->regCmd("CIRWrite", 4, new CirWriteCmd)
+         cmdMgr->regCmd("CIRWrite", 4, new CirWriteCmd) &&
+         cmdMgr->regCmd("CIRSAve", 5, new CirSaveCmd) &&
+         cmdMgr->regCmd("CIRLoad", 4, new CirLoadCmd)
       )) {
       cerr << "Registering \"cir\" commands fails... exiting" << endl;
       return false;
@@ -327,6 +331,42 @@ CirOptCmd::help() const
         << "perform trivial optimizations\n";
 }
 
+//----------------------------------------------------------------------
+//    CIRCOMPact
+//----------------------------------------------------------------------
+CmdExecStatus
+CirCompactCmd::exec(const string& option)
+{
+   if (!cirMgr) {
+      cerr << "Error: circuit is not yet constructed!!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+   // check option
+   vector<string> options;
+   CmdExec::lexOptions(option, options);
+
+   if (!options.empty())
+      return CmdExec::errorOption(CMD_OPT_EXTRA, options[0]);
+
+   assert(curCmd != CIRINIT);
+   cirMgr->compact();
+
+   return CMD_EXEC_DONE;
+}
+
+void
+CirCompactCmd::usage(ostream& os) const
+{
+   os << "Usage: CIRCOMPact" << endl;
+}
+
+void
+CirCompactCmd::help() const
+{
+   cout << setw(15) << left << "CIRCOMPact: "
+        << "renumber the gates densely in DFS order\n";
+}
+
 //----------------------------------------------------------------------
 //    CIRSTRash
 //----------------------------------------------------------------------
@@ -389,13 +429,23 @@ CirSimCmd::exec(const string& option)
    CmdExec::lexOptions(option, options);
 
    ifstream patternFile;
+   string patternName, logName;
    ofstream logFile;
-   bool doRandom = false, doFile = false, doLog = false;
+   bool doRandom = false, doFile = false, doLog = false, doThread = false;
+   bool doSeed = false, doGain = false, doLimit = false;
+   int threads = 0, seed = 0, limit = 0;
+   double gain = 0;
    for (size_t i = 0, n = options.size(); i < n; ++i) {
       if (myStrNCmp("-Random", options[i], 2) == 0) {
          if (doRandom || doFile)
             return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
          doRandom = true;
+         // optional seed
+         if (i + 1 < n && myStr2Int(options[i+1], seed)) {
+            if (seed < 0)
+               return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i+1]);
+            doSeed = true; ++i;
+         }
       }
       else if (myStrNCmp("-File", options[i], 2) == 0) {
          if (doRandom || doFile)
@@ -405,6 +455,7 @@ CirSimCmd::exec(const string& option)
          patternFile.open(options[i].c_str(), ios::in);
          if (!patternFile)
             return CmdExec::errorOption(CMD_OPT_FOPEN_FAIL, options[i]);
+         patternName = options[i];
          doFile = true;
       }
       else if (myStrNCmp("-Output", options[i], 2) == 0) {
@@ -412,11 +463,38 @@ CirSimCmd::exec(const string& option)
             return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
          if (++i == n)
             return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
-         logFile.open(options[i].c_str(), ios::out);
-         if (!logFile)
-            return CmdExec::errorOption(CMD_OPT_FOPEN_FAIL, options[i]);
+         logName = options[i];
          doLog = true;
       }
+      else if (myStrNCmp("-Gain", options[i], 2) == 0) {
+         if (doGain)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         char* end;
+         gain = strtod(options[i].c_str(), &end);
+         if (*end || options[i].empty() || gain < 0 || gain >= 1)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         doGain = true;
+      }
+      else if (myStrNCmp("-Limit", options[i], 2) == 0) {
+         if (doLimit)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (!myStr2Int(options[i], limit) || limit < 0)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         doLimit = true;
+      }
+      else if (myStrNCmp("-Threads", options[i], 2) == 0) {
+         if (doThread)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (!myStr2Int(options[i], threads) || threads < 0)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         doThread = true;
+      }
       else
          return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
    }
@@ -425,14 +503,30 @@ CirSimCmd::exec(const string& option)
       return CmdExec::errorOption(CMD_OPT_MISSING, "");
 
    assert (curCmd != CIRINIT);
+   if (doLog) {
+      // the response to packed patterns is binary
+      if (doFile && cirMgr->isPackedPatternFile(patternFile))
+         logFile.open(logName.c_str(), ios::out | ios::binary);
+      else logFile.open(logName.c_str(), ios::out);
+      if (!logFile)
+         return CmdExec::errorOption(CMD_OPT_FOPEN_FAIL, logName);
+   }
    if (doLog)
       cirMgr->setSimLog(&logFile);
    else cirMgr->setSimLog(0);
+   if (doThread)
+      cirMgr->setSimThreads(threads);
+   if (doSeed)
+      cirMgr->setSimSeed(seed);
+   if (doGain)
+      cirMgr->setSimGain(gain);
+   if (doLimit)
+      cirMgr->setSimTimeLimit(limit);
 
    if (doRandom)
       cirMgr->randomSim();
    else
-      cirMgr->fileSim(patternFile);
+      cirMgr->fileSim(patternFile, patternName);
    cirMgr->setSimLog(0);
    curCmd = CIRSIMULATE;
    
@@ -442,8 +536,10 @@ CirSimCmd::exec(const string& option)
 void
 CirSimCmd::usage(ostream& os) const
 {
-   os << "Usage: CIRSIMulate <-Random | -File <string patternFile>>\n"
-      << "                   [-Output (string logFile)]" << endl;
+   os << "Usage: CIRSIMulate <-Random [(int seed)] | -File <string patternFile>>\n"
+      << "                   [-Output (string logFile)] [-Threads (int n)]\n"
+      << "                   [-Gain (double rate)] [-Limit (int seconds)]"
+      << endl;
 }
 
 void
@@ -494,7 +590,7 @@ CirFraigCmd::help() const
 }
 
 //----------------------------------------------------------------------
-//    CIRWrite [(int gateId)][-Output (string aagFile)]
+//    CIRWrite [(int gateId)][-Output (string aagFile)][-Binary]
 //----------------------------------------------------------------------
 CmdExecStatus
 CirWriteCmd::exec(const string& option)
@@ -511,9 +607,10 @@ CirWriteCmd::exec(const string& option)
       cirMgr->writeAag(cout);
       return CMD_EXEC_DONE;
    }
-   bool hasFile = false;
+   bool hasFile = false, doBinary = false;
    int gateId;
    CirGate *thisGate = NULL;
+   string fileName;
    ofstream outfile;
    for (size_t i = 0, n = options.size(); i < n; ++i) {
       if (myStrNCmp("-Output", options[i], 2) == 0) {
@@ -521,11 +618,14 @@ CirWriteCmd::exec(const string& option)
             return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
          if (++i == n)
             return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
-         outfile.open(options[i].c_str(), ios::out);
-         if (!outfile)
-            return CmdExec::errorOption(CMD_OPT_FOPEN_FAIL, options[1]);
+         fileName = options[i];
          hasFile = true;
       }
+      else if (myStrNCmp("-Binary", options[i], 2) == 0) {
+         if (doBinary)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         doBinary = true;
+      }
       else if (myStr2Int(options[i], gateId) && gateId >= 0) {
          if (thisGate != NULL)
             return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
@@ -542,9 +642,23 @@ CirWriteCmd::exec(const string& option)
       else return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
    }
 
-   if (!thisGate) {
-      assert (hasFile);
-      cirMgr->writeAag(outfile);
+   if (doBinary) {
+      if (thisGate)
+         return CmdExec::errorOption(CMD_OPT_ILLEGAL, "-Binary");
+      if (!hasFile)
+         return CmdExec::errorOption(CMD_OPT_MISSING, "-Output");
+   }
+   if (hasFile) {
+      outfile.open(fileName.c_str(), doBinary? ios::out | ios::binary: ios::out);
+      if (!outfile)
+         return CmdExec::errorOption(CMD_OPT_FOPEN_FAIL, fileName);
+   }
+
+   if (doBinary)
+      cirMgr->writeAig(outfile);
+   else if (!thisGate) {
+      if (hasFile) cirMgr->writeAag(outfile);
+      else cirMgr->writeAag(cout);
    }
    else if (hasFile) cirMgr->writeGate(outfile, thisGate);
    else cirMgr->writeGate(cout, thisGate);
@@ -555,13 +669,118 @@ CirWriteCmd::exec(const string& option)
 void
 CirWriteCmd::usage(ostream& os) const
 {
-   os << "Usage: CIRWrite [(int gateId)][-Output (string aagFile)]" << endl;
+   os << "Usage: CIRWrite [(int gateId)][-Output (string aagFile)][-Binary]"
+      << endl;
 }
 
 void
 CirWriteCmd::help() const
 {
    cout << setw(15) << left << "CIRWrite: "
-        << "write the netlist to an ASCII AIG file (.aag)\n";
+        << "write the netlist to an AIG file (.aag or binary .aig)\n";
 }
 
+
+//----------------------------------------------------------------------
+//    CIRSAve <(string snapFile)>
+//----------------------------------------------------------------------
+CmdExecStatus
+CirSaveCmd::exec(const string& option)
+{
+   if (!cirMgr) {
+      cerr << "Error: circuit is not yet constructed!!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+   string token;
+   if (!CmdExec::lexSingleOption(option, token, false))
+      return CMD_EXEC_ERROR;
+
+   if (!cirMgr->saveSnapshot(token, curCmd))
+      return CMD_EXEC_ERROR;
+
+   return CMD_EXEC_DONE;
+}
+
+void
+CirSaveCmd::usage(ostream& os) const
+{
+   os << "Usage: CIRSAve <(string snapFile)>" << endl;
+}
+
+void
+CirSaveCmd::help() const
+{
+   cout << setw(15) << left << "CIRSAve: "
+        << "save the circuit, simulation and FEC state to a snapshot\n";
+}
+
+//----------------------------------------------------------------------
+//    CIRLoad <(string snapFile)> [-Replace]
+//----------------------------------------------------------------------
+CmdExecStatus
+CirLoadCmd::exec(const string& option)
+{
+   // check option
+   vector<string> options;
+   if (!CmdExec::lexOptions(option, options))
+      return CMD_EXEC_ERROR;
+   if (options.empty())
+      return CmdExec::errorOption(CMD_OPT_MISSING, "");
+
+   bool doReplace = false;
+   string fileName;
+   for (size_t i = 0, n = options.size(); i < n; ++i) {
+      if (myStrNCmp("-Replace", options[i], 2) == 0) {
+         if (doReplace) return CmdExec::errorOption(CMD_OPT_EXTRA,options[i]);
+         doReplace = true;
+      }
+      else {
+         if (fileName.size())
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         fileName = options[i];
+      }
+   }
+
+   if (cirMgr != 0) {
+      if (doReplace) {
+         cerr << "Note: original circuit is replaced..." << endl;
+         curCmd = CIRINIT;
+         delete cirMgr; cirMgr = 0;
+      }
+      else {
+         cerr << "Error: circuit already exists!!" << endl;
+         return CMD_EXEC_ERROR;
+      }
+   }
+   cirMgr = new CirMgr;
+
+   unsigned state = CIRINIT;
+   bool ok = cirMgr->loadSnapshot(fileName, state);
+   if (ok && (state == CIRINIT || state >= CIRCMDTOT)) {
+      cerr << "Error: \"" << fileName << "\" is not a valid snapshot!!"
+           << endl;
+      ok = false;
+   }
+   if (!ok) {
+      curCmd = CIRINIT;
+      delete cirMgr; cirMgr = 0;
+      return CMD_EXEC_ERROR;
+   }
+
+   curCmd = CirCmdState(state);
+
+   return CMD_EXEC_DONE;
+}
+
+void
+CirLoadCmd::usage(ostream& os) const
+{
+   os << "Usage: CIRLoad <(string snapFile)> [-Replace]" << endl;
+}
+
+void
+CirLoadCmd::help() const
+{
+   cout << setw(15) << left << "CIRLoad: "
+        << "load a circuit snapshot saved by CIRSAve\n";
+}
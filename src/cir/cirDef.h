@@ -23,6 +23,73 @@ class SatSolver;
 typedef vector<CirGate*>           GateList;
 typedef vector<unsigned>           IdList;
 
+// Every gate carries CIR_SIM_WORDS 64-bit words of simulation value, so
+// one pass over the netlist simulates 64 * CIR_SIM_WORDS patterns.
+// Set it with -DCIR_SIM_WORDS=n, n = 1, 2, 4 or 8.
+// FEC groups are split on all n words of a pass at once, so for n > 1
+// the groups are listed in another order than with n = 1, and a gate
+// equal to another on some words and inverted on others is no longer
+// in its group. CIRGate shows the last 64 patterns simulated.
+#ifndef CIR_SIM_WORDS
+#define CIR_SIM_WORDS 8
+#endif
+#if CIR_SIM_WORDS != 1 && CIR_SIM_WORDS != 2 && CIR_SIM_WORDS != 4 && \
+    CIR_SIM_WORDS != 8
+#error "CIR_SIM_WORDS must be 1, 2, 4 or 8"
+#endif
+static const size_t SimWords = CIR_SIM_WORDS;
+
+// Packed fanin edge, the AIGER literal( 2 * gateId + invert ) in one word.
+// The default one is the null edge of a gate without that fanin.
+class CirGateV
+{
+public:
+   CirGateV(unsigned lId = NullLId) : _lId(lId) {}
+   CirGateV(size_t id, bool inv) : _lId(2 * id + inv) {}
+
+   size_t id() const { return _lId >> 1; }
+   bool isInv() const { return _lId & 1; }
+   unsigned lId() const { return _lId; }
+   bool isNull() const { return _lId == NullLId; }
+   void flipInv() { _lId ^= 1; }
+
+   bool operator == (const CirGateV& v) const { return _lId == v._lId; }
+   bool operator != (const CirGateV& v) const { return _lId != v._lId; }
+
+   static const unsigned NullLId = ~0u;
+
+private:
+   unsigned   _lId;
+};
+
+// One instruction of compiled simulation, sim( out ) = in0 & in1 with the
+// fanins as literals
+struct CirSimOp
+{
+   unsigned   out;
+   CirGateV   in0, in1;
+};
+
+// Visit marks of one traversal, indexed by gate id. Each traversal owns
+// its CirMark, so traversals on separate threads do not disturb each
+// other; start() begins the next traversal in O(1) with a new epoch.
+class CirMark
+{
+public:
+   CirMark(size_t n = 0) : _epoch(1), _mark(n, 0) {}
+
+   void start(size_t n) {
+      if (_mark.size() < n) _mark.resize(n, 0);
+      if (++_epoch == 0) { _mark.assign(_mark.size(), 0); _epoch = 1; }
+   }
+   bool isMarked(size_t id) const { return _mark[id] == _epoch; }
+   void mark(size_t id) { _mark[id] = _epoch; }
+
+private:
+   unsigned           _epoch;
+   vector<unsigned>   _mark;
+};
+
 enum GateType
 {
    UNDEF_GATE = 0,
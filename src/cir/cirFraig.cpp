@@ -63,16 +63,17 @@ CirMgr::strash()
   HashMap< HashKey, WrapperGate > hash( getHashSize( _netList.size() ) * 10 );
   for ( size_t i = 0 , n = _netList.size() ; i < n ; ++i ) {
     if ( _netList[ i ]->gateType() == AIG_GATE ) {
-      HashKey k( _netList[ i ]->invert( 0 ), _netList[ i ]->invert( 1 ), 
-                 _netList[ i ]->_faninList[ 0 ]->getId(), 
-                 _netList[ i ]->_faninList[ 1 ]->getId() );
+      const CirGateV* in = &_faninList[ 2 * _netList[ i ]->getId() ];
+      HashKey k( in[ 0 ].isInv(), in[ 1 ].isInv(), in[ 0 ].id(), in[ 1 ].id() );
       WrapperGate gate( _netList[ i ] ), mergeGate;
       if ( hash.check( k, mergeGate ) == true )  
         mergeGate.merge( gate );
       else hash.forceInsert( k, gate );
     }
   }
-  dfsTraversal();
+  // a gate only merges into an earlier one with the same fanins, so the
+  // DFS order just loses the merged gates
+  compactNetList();
   assignFecGrp();
 }
 
@@ -84,11 +85,11 @@ CirMgr::fraig()
   genProofModel( solver );
 
   sortFecGrpList();
-  while ( _fecGrpList.size() != 0 ) {
-    for ( int i = _fecGrpList.size() - 1 ; i >= 0 ; --i ) { 
-      if ( proofFecGrp( solver, _fecGrpList[ i ], count ) ) 
-        _fecGrpList.pop_back();
-      if ( ( count >= resim ) && ( _fecGrpList.size() > 0 ) ) {
+  while ( fecGrpNum() != 0 ) {
+    for ( int i = fecGrpNum() - 1 ; i >= 0 ; --i ) { 
+      if ( proofFecGrp( solver, i, count ) ) 
+        popFecGrp();
+      if ( ( count >= resim ) && ( fecGrpNum() > 0 ) ) {
         resimulate( count );
         count = 0; break;
       }
@@ -96,6 +97,7 @@ CirMgr::fraig()
   }
 
   dfsTraversal(); assignFecGrp();
+  if ( _simStale ) simulate();
 }
 
 /********************************************/
@@ -103,11 +105,7 @@ CirMgr::fraig()
 /********************************************/
 void
 CirMgr::resimulate( size_t& count ) {
-  for ( size_t j = 0, jn = ( count / 64 + 1 ) ; j < jn ; ++j ) {
-    for ( size_t k = 0, kn = _piList.size() ; k < kn ; ++k )   
-      _piList[ k ]->setSim( _satPattern[ j ][ k ] );
-    dfsTraversal(); simulate(); identifyFEC(); 
-  }
+  simulateWords( _satPattern, count / 64 + 1 );
 }
 
 bool
@@ -140,8 +138,8 @@ CirMgr::mergeGrp( vector< CirGate* >& fecGrp ) {
   cout << "Group" << endl;
   for ( int j = 1, jn = fecGrp.size() ; j < jn ; ++j ) {
     if ( fecGrp[ j ]->gateType() == AIG_GATE ) {
-      if ( ( fecGrp[ 0 ]->_faninList[ 0 ] == fecGrp[ j ] ) ||
-           ( fecGrp[ 0 ]->_faninList[ 1 ] == fecGrp[ j ] ) )
+      if ( ( fecGrp[ 0 ]->faninGate( 0 ) == fecGrp[ j ] ) ||
+           ( fecGrp[ 0 ]->faninGate( 1 ) == fecGrp[ j ] ) )
         SWAP( fecGrp[ 0 ], fecGrp[ j ] );
     }
     fraigMerge( fecGrp[ 0 ], fecGrp[ j ], fecGrp[ 0 ]->getSim() != fecGrp[ j ]->getSim() ); 
@@ -150,8 +148,7 @@ CirMgr::mergeGrp( vector< CirGate* >& fecGrp ) {
 }
 
 bool
-CirMgr::proofFecGrp( SatSolver& solver, vector< CirGate* >& fecGrp, 
-                     size_t& count ) { 
+CirMgr::proofFecGrp( SatSolver& solver, size_t grp, size_t& count ) { 
   /*
   cout << "proof" << endl;
   if ( ( fecGrp.size() >= 3 ) && ( fecGrp.size() <= 6 ) ) { 
@@ -164,25 +161,29 @@ CirMgr::proofFecGrp( SatSolver& solver, vector< CirGate* >& fecGrp,
   }
   cout << "done" << endl;
   */
-  int quit = 0, quitLimit = fecGrp.size() / 2;
-  vector< bool > set;
-  for ( size_t i = 0, in = fecGrp.size() ; i < in ; ++i ) 
-    set.push_back( true );
-  for ( size_t i = 0, in = fecGrp.size() ; i < in ; ++i ) {
+  unsigned* fecGrp = &_fecMemberList[ _fecBeginList[ grp ] ];
+  size_t n = _fecBeginList[ grp + 1 ] - _fecBeginList[ grp ];
+  int quit = 0, quitLimit = n / 2;
+  vector< bool > set( n, true );
+  for ( size_t i = 0 ; i < n ; ++i ) {
     if ( !set[ i ] ) continue;
-    for ( size_t j = i + 1, jn = fecGrp.size() ; j < jn ; ++j ) {
+    for ( size_t j = i + 1 ; j < n ; ++j ) {
       if ( !set[ j ] ) continue;
       bool b;
-      if ( fecGrp[ i ]->getSim() == fecGrp[ j ]->getSim() ) b = false;
-      else                                                  b = true;
+      if ( getSim( fecGrp[ i ] ) == getSim( fecGrp[ j ] ) ) b = false;
+      else                                                   b = true;
 
-      if ( proofFecPair( solver, fecGrp[ i ], fecGrp[ j ], b ) ) {
-        if ( fecGrp[ i ]->gateType() == AIG_GATE ) {
-          if ( ( fecGrp[ i ]->_faninList[ 0 ] == fecGrp[ j ] ) ||
-               ( fecGrp[ i ]->_faninList[ 1 ] == fecGrp[ j ] ) )
-            SWAP( fecGrp[ i ], fecGrp[ j ] );
+      CirGate* gi = _totalList[ fecGrp[ i ] ];
+      CirGate* gj = _totalList[ fecGrp[ j ] ];
+      if ( proofFecPair( solver, gi, gj, b ) ) {
+        if ( gi->gateType() == AIG_GATE ) {
+          const CirGateV* in = &_faninList[ 2 * fecGrp[ i ] ];
+          if ( ( in[ 0 ].id() == fecGrp[ j ] ) ||
+               ( in[ 1 ].id() == fecGrp[ j ] ) ) {
+            SWAP( fecGrp[ i ], fecGrp[ j ] ); SWAP( gi, gj );
+          }
         }
-        fraigMerge( fecGrp[ i ], fecGrp[ j ], b ); set[ j ] = false; 
+        fraigMerge( gi, gj, b ); set[ j ] = false; 
       }
       else {
         setSatPattern( solver, count );
@@ -202,7 +203,7 @@ CirMgr::setSatPattern( SatSolver& solver, size_t& count ) {
     _satPattern.push_back( _satPattern[ 0 ] );
   for ( int k = 0, kn = _piList.size() ; k < kn ; ++k ) {
     _satPattern[ index ][ k ] = _satPattern[ index ][ k ] << 1;
-    _satPattern[ index ][ k ] += solver.getValue( _piList[ k ]->getVar() );
+    _satPattern[ index ][ k ] += solver.getValue( _varList[ _piList[ k ]->getId() ] );
   }
   ++count;
 }
@@ -222,7 +223,9 @@ CirMgr::fraigMerge( CirGate* newGate, CirGate* tempGate, bool ifec ) {
   cout << "Fraig: " << newGate->getId() << " merging ";
   if ( ifec ) cout << "!";
   cout << tempGate->getId() << "..." << endl;
+  bool ordered = keepOrder( newGate, tempGate );
   replaceGate( tempGate, newGate, ifec );
+  if ( !ordered ) dfsTraversal();
 }
 
 void
@@ -244,26 +247,26 @@ CirMgr::resetSatPattern() {
 bool 
 CirMgr::proofFecPair( SatSolver& solver, CirGate* g1, CirGate* g2, bool ifec ) {
   Var newV = solver.newVar();
-  solver.addXorCNF(newV, g1->getVar(), false, g2->getVar(), ifec );
+  solver.addXorCNF(newV, _varList[ g1->getId() ], false, 
+                   _varList[ g2->getId() ], ifec );
   solver.assumeRelease();  // Clear assumptions
-  solver.assumeProperty( _totalList[ 0 ]->getVar(), false );
+  solver.assumeProperty( _varList[ 0 ], false );
   solver.assumeProperty(newV, true);  // k = 1
   return !solver.assumpSolve();
 }
 
 void 
 CirMgr::genProofModel( SatSolver& s ) {
-  Var v = s.newVar();
-  _totalList[ 0 ]->setVar( v );
+  _varList[ 0 ] = s.newVar();
   for (size_t i = 0, n = _netList.size(); i < n; ++i)
     if ( _netList[ i ]->gateType() != PO_GATE ) {
-      Var v = s.newVar();    
-      _netList[ i ]->setVar( v );
+      size_t id = _netList[ i ]->getId();
+      _varList[ id ] = s.newVar();
       if ( _netList[ i ]->gateType() == AIG_GATE ) {
-        CirGate* g = _netList[ i ];
-        s.addAigCNF( g->getVar(), 
-                     g->_faninList[ 0 ]->getVar(), g->invert( 0 ), 
-                     g->_faninList[ 1 ]->getVar(), g->invert( 1 ) );
+        const CirGateV* in = &_faninList[ 2 * id ];
+        s.addAigCNF( _varList[ id ], 
+                     _varList[ in[ 0 ].id() ], in[ 0 ].isInv(), 
+                     _varList[ in[ 1 ].id() ], in[ 1 ].isInv() );
       }
     }
   resim = setReSimNum( _netList.size() );
@@ -273,36 +276,36 @@ CirMgr::genProofModel( SatSolver& s ) {
 class WFec {
  public:
   WFec() {}
-  WFec( unsigned long long a, vector< CirGate* > b ): d( a ), fecGrp( b ) {}
+  WFec( unsigned long long a, size_t b ): d( a ), grp( b ) {}
   unsigned long long d;
-  vector< CirGate* > fecGrp;
+  size_t grp;
 };
 bool 
 wFecCompare( WFec a, WFec b ) { return ( a.d > b.d ); }
 void 
 CirMgr::sortFecGrpList() {
-  for ( size_t i = 0, in = _netList.size() ; i < in ; ++i ) {
-    if ( _netList[ i ]->gateType() == AIG_GATE ) {
-      _netList[ i ]->_d = ( _netList[ i ]->_faninList[ 0 ]->_d > _netList[ i ]->_faninList[ 1 ]->_d )
-                          ? ( _netList[ i ]->_faninList[ 0 ]->_d + 1 )
-                          : ( _netList[ i ]->_faninList[ 1 ]->_d + 1 );
-    }
-    else if ( _netList[ i ]->gateType() == PI_GATE )
-      _netList[ i ]->_d = 0;
-    else if ( _netList[ i ]->gateType() == CONST_GATE )
-      _netList[ i ]->_d = 0;
-  }
+  computeLevel();
   vector< WFec > temp;
   unsigned long long d;
-  for ( size_t i = 0, in = _fecGrpList.size() ; i < in ; ++i ) {
+  for ( size_t i = 0, in = fecGrpNum() ; i < in ; ++i ) {
     d = 0;
-    for ( size_t j = 0, jn = _fecGrpList[ i ].size() ; j < jn ; ++j )
-      d += _fecGrpList[ i ][ j ]->_d;
-    temp.push_back( WFec( d, _fecGrpList[ i ] ) );
+    for ( size_t j = _fecBeginList[ i ], jn = _fecBeginList[ i + 1 ] ; 
+          j < jn ; ++j )
+      d += _levelList[ _fecMemberList[ j ] ];
+    temp.push_back( WFec( d, i ) );
   }
   sort( temp.begin(), temp.end(), wFecCompare );
-  for ( size_t i = 0, in = _fecGrpList.size() ; i < in ; ++i ) 
-    _fecGrpList[ i ] = temp[ i ].fecGrp;
+  IdList members, begins( 1, 0 );
+  members.reserve( _fecMemberList.size() );
+  for ( size_t i = 0, in = temp.size() ; i < in ; ++i ) {
+    size_t g = temp[ i ].grp;
+    members.insert( members.end(), 
+                    _fecMemberList.begin() + _fecBeginList[ g ],
+                    _fecMemberList.begin() + _fecBeginList[ g + 1 ] );
+    begins.push_back( members.size() );
+  }
+  _fecMemberList.swap( members );
+  _fecBeginList.swap( begins );
 }
 
 /*
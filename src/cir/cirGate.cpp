@@ -26,8 +26,6 @@ extern CirMgr *cirMgr;
 /**************************************/
 /*   class CirGate member functions   */
 /**************************************/
-unsigned CirGate::_globalRef = 0;
-unsigned CirGate::_globalFraig = 0;
 size_t CirGate::_mask = 0;
 
 string int2str(int &i) {
@@ -47,17 +45,22 @@ CirGate::reportGate() const
   ss << _lineNo;
   string no = ss.str();
   string output = "= " + getTypeStr() + "(" + id + ")";
-  if ( _symbol != "" ) output += "\"" + _symbol + "\"";
+  string symbol = getSymbol();
+  if ( symbol != "" ) output += "\"" + symbol + "\"";
   output += ", line " + no;
   cout << "==================================================" << endl;
   cout << setw(49) << left << output << "=" << endl;
   ss.str( "" ); ss.clear();
   output = "= FECs: ";
-  for ( size_t i = 0, in = _fecGrp.size() ; i < in ; ++i ) { 
-    if ( _fecGrp[ i ] != this ) {
-      if ( _simValue != _fecGrp[ i ]->getSim() ) 
+  unsigned long long simValue = getSim();
+  CirGateV fec = cirMgr->getFecGrp( _gateId );
+  for ( size_t i = 0, in = fec.isNull() ? 0 : cirMgr->getFecGrpSize( fec.id() ) ;
+        i < in ; ++i ) { 
+    unsigned m = cirMgr->getFecMember( fec.id(), i );
+    if ( m != _gateId ) {
+      if ( fec.isInv() != cirMgr->getFecGrp( m ).isInv() ) 
         output += "!";
-      ss << _fecGrp[ i ]->getId();
+      ss << m;
       output += ss.str() + " ";
       ss.str( "" ); ss.clear();
     }
@@ -68,7 +71,7 @@ CirGate::reportGate() const
   for ( int i = 0 ; i < 32 ; ++i ) {
     if ( ( ( i % 4 ) == 0 ) && ( i != 0 ) )
       cout << "_";
-    if ( s & _simValue ) cout << "1";
+    if ( s & simValue ) cout << "1";
     else                 cout << "0";
     s = s >> 1;
   }
@@ -80,33 +83,33 @@ void
 CirGate::reportFanin(int level) const
 {
    assert (level >= 0);
-   CirGate::setGlobalRef();
+   CirMark mark( cirMgr->getTotalSize() );
    cout << getTypeStr() << " " << _gateId << endl; 
    if ( level > 0 ) {
-     for ( int i = 0 ; i < _faninList.size() ; i++ ) {
+     for ( int i = 0 ; i < faninSize() ; i++ ) {
        cout << "  "; 
-       _faninList[ i ]->reportFanin( level - 1, 2, this->invert( i ) );
+       faninGate( i )->reportFanin( level - 1, 2, this->invert( i ), mark );
      }
    }
-   this->setToGlobalRef();
 }
 
 void 
-CirGate::reportFanin( int level, int time, bool invert ) const 
+CirGate::reportFanin( int level, int time, bool invert, CirMark& mark ) const 
 {
   assert( level >= 0 );
   if ( invert ) cout << "!";
   cout << getTypeStr() << " " << _gateId;
-  if ( ( level != 0 ) && ( this->isGlobalRef() ) && ( _faninList.size() != 0 ) )
+  if ( ( level != 0 ) && ( mark.isMarked( _gateId ) ) && ( faninSize() != 0 ) )
     cout << " (*)" << endl;
   else {
     cout << endl;
     if ( level > 0 ) {
-      for ( int i = 0 ; i < _faninList.size() ; i++ ) {
+      for ( int i = 0 ; i < faninSize() ; i++ ) {
         for ( int j = 0 ; j < time ; j++ ) cout << "  ";
-        _faninList[ i ]->reportFanin( level - 1, time + 1, this->invert( i ) );
+        faninGate( i )->reportFanin( level - 1, time + 1, this->invert( i ), 
+                                     mark );
       }
-      this->setToGlobalRef();
+      mark.mark( _gateId );
     }
   }
 }
@@ -115,63 +118,90 @@ void
 CirGate::reportFanout(int level) const
 {
    assert (level >= 0);
-   CirGate::setGlobalRef();
+   CirMark mark( cirMgr->getTotalSize() );
    cout << getTypeStr() << " " << _gateId << endl; 
    if ( level > 0 ) {
-     for ( int i = 0 ; i < _fanoutList.size() ; i++ ) {
+     for ( unsigned e = cirMgr->getFanoutHead( _gateId ) ; 
+           e != CirMgr::NoEdge ; e = cirMgr->getNextFanout( e ) ) {
        cout << "  "; 
-       _fanoutList[ i ]->reportFanout( level - 1, 2, this );
+       cirMgr->getGate( e / 2 )->reportFanout( level - 1, 2, this, mark );
      }
    }
-   this->setToGlobalRef();
 }
 
 void 
-CirGate::reportFanout( int level, int time, const CirGate* parent ) const 
+CirGate::reportFanout( int level, int time, const CirGate* parent, 
+                       CirMark& mark ) const 
 {
   assert( level >= 0 );
   int index;
-  for ( int i = 0 ; i < _faninList.size() ; i++ ) 
-    if ( _faninList[ i ] == parent ) 
+  for ( int i = 0 ; i < faninSize() ; i++ ) 
+    if ( faninGate( i ) == parent ) 
       index = i;
   if ( this->invert( index ) ) cout << "!";
   cout << getTypeStr() << " " << _gateId;
-  if ( ( level != 0 ) && ( this->isGlobalRef() ) && ( _fanoutList.size() != 0 ) )
+  if ( ( level != 0 ) && ( mark.isMarked( _gateId ) ) && ( fanoutSize() != 0 ) )
     cout << " (*)" << endl;
   else {
     cout << endl;
     if ( level > 0 ) {
-      for ( int i = 0 ; i < _fanoutList.size() ; i++ ) {
+      for ( unsigned e = cirMgr->getFanoutHead( _gateId ) ; 
+            e != CirMgr::NoEdge ; e = cirMgr->getNextFanout( e ) ) {
         for ( int j = 0 ; j < time ; j++ ) cout << "  ";
-        _fanoutList[ i ]->reportFanout( level - 1, time + 1, this );
+        cirMgr->getGate( e / 2 )->reportFanout( level - 1, time + 1, this, 
+                                                mark );
       }
-      this->setToGlobalRef();
+      mark.mark( _gateId );
     }
   }
 }
 
+unsigned long long
+CirGate::getSim() const
+{
+  return cirMgr->getSim( _gateId );
+}
+
+Var
+CirGate::getVar() const
+{
+  return cirMgr->getVar( _gateId );
+}
+
+string
+CirGate::getSymbol() const
+{
+  return cirMgr->getSymbol( _gateId );
+}
+
 size_t
 CirGate::getId() const 
 {
   return _gateId;
 }
 
-GateType
-CirGate::faninType( int index ) const
+CirGateV
+CirGate::fanin( int index ) const
 {
-  return _faninList[ index ]->gateType();
+  return cirMgr->getFanin( _gateId, index );
 }
 
-int
-CirGate::faninSize() const 
+CirGate*
+CirGate::faninGate( int index ) const
+{
+  return cirMgr->getGate( fanin( index ).id() );
+}
+
+GateType
+CirGate::faninType( int index ) const
 {
-  return _faninList.size();
+  return faninGate( index )->gateType();
 }
 
 int
 CirGate::fanoutSize() const 
 {
-  return _fanoutList.size();
+  return cirMgr->getFanoutNum( _gateId );
 }
 
 void 
@@ -182,8 +212,9 @@ CirUndefGate::printGate() const {
 void 
 CirPiGate::printGate() const {
   cout << "PI  " << _gateId;
-  if ( _symbol != "" ) 
-    cout << " (" << _symbol << ")";
+  string symbol = getSymbol();
+  if ( symbol != "" ) 
+    cout << " (" << symbol << ")";
   cout << endl;
 }
 
@@ -191,24 +222,25 @@ void
 CirPoGate::printGate() const {
   cout << "PO  " << _gateId;
   cout << " ";
-  if ( _faninList[ 0 ]->gateType() == UNDEF_GATE ) 
+  if ( faninType( 0 ) == UNDEF_GATE ) 
     cout << "*";
-  if ( _invert ) cout << "!";
-  cout << _faninList[ 0 ]->getId();
-  if ( _symbol != "" ) 
-    cout << " (" << _symbol << ")";
+  if ( invert( 0 ) ) cout << "!";
+  cout << fanin( 0 ).id();
+  string symbol = getSymbol();
+  if ( symbol != "" ) 
+    cout << " (" << symbol << ")";
   cout << endl;
 }
 
 void 
 CirAigGate::printGate() const {
   cout << "AIG " << _gateId;
-  for ( int i = 0 ; i < _faninList.size() ; i++ ) {
+  for ( int i = 0 ; i < faninSize() ; i++ ) {
     cout << " ";
-    if ( _faninList[ i ]->gateType() == UNDEF_GATE ) 
+    if ( faninType( i ) == UNDEF_GATE ) 
       cout << "*";
-    if ( _invert[ i ] ) cout << "!";
-    cout << _faninList[ i ]->getId();
+    if ( invert( i ) ) cout << "!";
+    cout << fanin( i ).id();
   }
   cout << endl;
 }
@@ -217,31 +249,3 @@ void
 CirConstGate::printGate() const {
   cout << "CONST0" << endl;
 }
-
-void 
-CirUndefGate::simulate() {
-  //return false;
-}
-
-void 
-CirPiGate::simulate() {
-  //return true;
-}
-
-void
-CirPoGate::simulate() {
-  _simValue = _faninList[ 0 ]->getSim();
-  _simValue = ( _invert ) ? ( ~_simValue ) : ( _simValue );
-}
-
-void
-CirAigGate::simulate() {
-  unsigned long long in0 = _faninList[ 0 ]->getSim(), in1 = _faninList[ 1 ]->getSim();
-  in0 = ( _invert[ 0 ] ) ? ( ~in0 ) : in0; 
-  in1 = ( _invert[ 1 ] ) ? ( ~in1 ) : in1;
-  _simValue = in0 & in1;
-}
-
-void
-CirConstGate::simulate() {
-}
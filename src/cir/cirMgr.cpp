@@ -16,6 +16,8 @@
 #include "cirMgr.h"
 #include "cirGate.h"
 #include "util.h"
+#include "myFile.h"
+#include "myThread.h"
 
 using namespace std;
 
@@ -25,6 +27,8 @@ using namespace std;
 /*   Global variable and enum  */
 /*******************************/
 CirMgr* cirMgr = 0;
+const unsigned CirGateV::NullLId;
+const unsigned CirMgr::NoEdge;
 
 enum CirParseError {
    EXTRA_SPACE,
@@ -59,6 +63,49 @@ static string errMsg;
 static int errInt;
 static CirGate *errGate;
 
+// _rankList entry of a gate that is not in _netList
+static const unsigned NoRank = ~0u;
+
+struct RankLess
+{
+   RankLess( const IdList& rank ) : _rank( rank ) {}
+   bool operator () ( const CirGate* a, const CirGate* b ) const {
+      return _rank[ a->getId() ] < _rank[ b->getId() ]; }
+   const IdList& _rank;
+};
+
+// 7 bits per byte, LSB group first, MSB set if more bytes follow
+static bool
+decodeAigDelta( const char*& p, const char* end, unsigned& delta )
+{
+   delta = 0;
+   for ( unsigned shift = 0 ; shift < 32 && p != end ; shift += 7 ) {
+      unsigned char ch = *p++;
+      delta |= ( unsigned )( ch & 0x7f ) << shift;
+      if ( !( ch & 0x80 ) ) return true;
+   }
+   return false;
+}
+
+static void
+encodeAigDelta( string& buf, unsigned delta )
+{
+   while ( delta & ~0x7f ) {
+      buf += char( ( delta & 0x7f ) | 0x80 );
+      delta >>= 7;
+   }
+   buf += char( delta );
+}
+
+static void
+appendUInt( string& buf, size_t n )
+{
+   char digit[ 24 ];
+   int len = 0;
+   do { digit[ len++ ] = '0' + n % 10; n /= 10; } while ( n );
+   while ( len ) buf += digit[ --len ];
+}
+
 static bool
 parseError(CirParseError err)
 {
@@ -146,167 +193,465 @@ parseError(CirParseError err)
    return false;
 }
 
+// Hand-rolled lexer on the mapped file, nothing is allocated per line.
+// lineBegin is only used for the column number of an error.
+static const char* lineBegin = 0;
+
+static bool
+lexLId( const char*& p, const char* end, unsigned& n, const char* type )
+{
+   colNo = p - lineBegin;
+   if ( p == end || *p == '\n' ) {
+      errMsg = type;
+      return parseError( MISSING_NUM );
+   }
+   if ( *p == ' ' ) return parseError( EXTRA_SPACE );
+   const char* begin = p;
+   for ( n = 0 ; p != end && isdigit( *p ) ; ++p )
+      n = n * 10 + ( *p - '0' );
+   if ( p == begin || ( p != end && *p != ' ' && *p != '\n' ) ) {
+      while ( p != end && *p != ' ' && *p != '\n' ) ++p;
+      errMsg = string( type ) + "(" + string( begin, p ) + ")";
+      return parseError( ILLEGAL_NUM );
+   }
+   return true;
+}
+
+static bool
+lexSpace( const char*& p, const char* end )
+{
+   colNo = p - lineBegin;
+   if ( p == end || *p != ' ' ) return parseError( MISSING_SPACE );
+   ++p;
+   return true;
+}
+
+// the last line may end without '\n'
+static bool
+lexNewLine( const char*& p, const char* end )
+{
+   colNo = p - lineBegin;
+   if ( p == end ) return true;
+   if ( *p != '\n' ) return parseError( MISSING_NEWLINE );
+   lineBegin = ++p;
+   return true;
+}
+
+// one line of the AND section for the multi-threaded parser: no message is
+// printed, the serial parser reports whatever makes it return false
+static inline bool
+lexAigLine( const char*& p, const char* end, unsigned* lId, unsigned maxLId )
+{
+   for ( int j = 0 ; j < 3 ; ++j ) {
+      if ( p == end || !isdigit( *p ) ) return false;
+      unsigned n = 0;
+      while ( p != end && isdigit( *p ) ) n = n * 10 + ( *p++ - '0' );
+      if ( n > maxLId ) return false;
+      lId[ j ] = n;
+      if ( j < 2 && ( p == end || *p++ != ' ' ) ) return false;
+   }
+   if ( p != end && *p++ != '\n' ) return false;
+   return ( lId[ 0 ] % 2 == 0 ) && ( lId[ 0 ] / 2 != 0 );
+}
+
+static const size_t ParallelAigNum = 1 << 16;
+
+// shared state of the multi-threaded parser, indexed by thread
+struct AigParseJob
+{
+   AigParseJob( size_t n ): 
+     nThreads( n ), fail( n, 0 ), undefAig( n ) {}
+
+   size_t                      nThreads;
+   const char*                 end;
+   const char*                 sectionEnd;
+   size_t                      aigNum;
+   unsigned                    maxLId;
+   unsigned                    lineBase;
+   vector< const char* >       chunk;     // line-aligned chunk bounds
+   vector< size_t >            firstLine; // AND index of chunk[ t ]
+   vector< char >              fail;
+   char*                       gateSlot;  // one arena slot per AND
+   vector< vector< size_t > >  undefAig;
+   vector< vector< size_t > >  edge;      // [ from * nThreads + owner ]
+};
+
+// every gate class fits in one arena slot
+static size_t
+gateSlotSize() {
+  size_t s = sizeof( CirUndefGate );
+  if ( s < sizeof( CirPiGate ) )    s = sizeof( CirPiGate );
+  if ( s < sizeof( CirPoGate ) )    s = sizeof( CirPoGate );
+  if ( s < sizeof( CirAigGate ) )   s = sizeof( CirAigGate );
+  if ( s < sizeof( CirConstGate ) ) s = sizeof( CirConstGate );
+  return s;
+}
+
 /**************************************************************/
 /*   class CirMgr member functions for circuit construction   */
 /**************************************************************/
+CirMgr::CirMgr(): _simLog( 0 ), _simThreads( 0 ), _simTuned( 0 ), _simSeed( 0 ), 
+                  _simRound( 0 ), _simGain( 0 ), _simTimeLimit( 0 ), 
+                  _simWord( 0 ), _simStale( false ),
+                  _gateArena( gateSlotSize() ) {}
+
 bool
 CirMgr::readCircuit(const string& fileName)
 {
-  ifstream ifs( fileName.c_str() );
+  MyMappedFile file;
   //errorhandling 1.
-  if ( ifs == 0 ) {
+  if ( !file.open( fileName ) ) {
     cout << "Cannot open design \"" << fileName << "\"!!" << endl;
     return false;
   }
-  string input;
-  getline( ifs, input, '\n' );
+  const char* p = file.begin(), *end = file.end();
+  const char* eol = p;
+  while ( eol != end && *eol != '\n' ) ++eol;
+  string input( p, eol );
+  p = lineBegin = ( eol == end ) ? end : eol + 1;
   //get M, I, L, O, A, L should be 0
   //corresponding to miloa[ 0, 1, 2, 3, 4 ]
-  vector< int > miloa = MILOA( input );
+  bool binary = false;
+  lineNo = 0;
+  vector< int > miloa = MILOA( input, binary );
   lineNo++;
   if ( miloa.size() == 0 ) { clear(); return false; }
-  //for create fanoutList
-  vector< vector< unsigned > > allId;
-  //store Literal ID of PI and AIG
-  vector< vector< int > > allLId;
   _maxVariables = miloa[ 0 ];
   //for getGate() 
-  for ( int i = 0 ; i < (  _maxVariables + miloa[ 3 ] + 1 + 100 ) ; ++i )
-    _totalList.push_back( NULL );
+  _totalList.resize( _maxVariables + miloa[ 3 ] + 1 + 100, NULL );
+  initStore();
   //create constGate
   createConstGate();
+  //binary AIGER( "aig" ), ANDs are delta-encoded
+  bool ok = binary ? readAig( p, end, miloa ) : readAag( p, end, miloa );
+  if ( !ok ) { clear(); return false; }
+  //create _netList, dfsTraversal
+  dfsTraversal();
+  //symbol section
+  parseSymbol( p, end );
+  return true;
+}
+
+// Two linear passes over the mapped file: the first lexes every literal
+// into the fanin store and creates the defined gates, the second one
+// creates the UNDEF gates and connects fanouts.
+bool
+CirMgr::readAag( const char*& p, const char* end, const vector< int >& miloa )
+{
+  unsigned maxLId = 2 * _maxVariables + 1;
   //Primary Input
-  for ( int i = 0 ; i < miloa[ 1 ] ; i++ ) {
-    getline( ifs, input, '\n' );
-    int lId;
-    myStr2Int( input, lId );
-    vector< int > storePILId;
-    storePILId.push_back( lId );
-    allLId.push_back( storePILId );
-    if ( ( lId / 2 ) != 0 ) {
-      CirGate* newGate = new CirPiGate( lId / 2, ++lineNo );
-      _piList.push_back( newGate );
-      _totalList[ lId / 2 ] = newGate;
-    }
-    else   
-      _piList.push_back( getGate( 0 ) );
+  _piList.reserve( miloa[ 1 ] );
+  for ( int i = 0 ; i < miloa[ 1 ] ; ++i ) {
+    unsigned lId;
+    if ( !lexLId( p, end, lId, "PI literal ID" ) ) return false;
+    if ( !checkDefLId( lId, maxLId, "PI" ) ) return false;
+    if ( !lexNewLine( p, end ) ) return false;
+    CirGate* newGate = createGate< CirPiGate >( lId / 2, ++lineNo );
+    _piList.push_back( newGate );
+    _totalList[ lId / 2 ] = newGate;
   }
   //Primary Output 
-  //get LID, but not create CirPoGate
-  vector< int > outputLId;
+  //fanin gates are looked up after the AND section
   unsigned outputId = _maxVariables + 1;
-  for ( int i = 0 ; i < miloa[ 3 ] ; i++ ) {
-    getline( ifs, input, '\n' );
-    int lId;
-    myStr2Int( input, lId);
-    outputLId.push_back( lId );
-    //create POGate
-    CirGate* newGate = new CirPoGate( outputId, lId % 2, ++lineNo );
+  _poList.reserve( miloa[ 3 ] );
+  for ( int i = 0 ; i < miloa[ 3 ] ; ++i ) {
+    unsigned lId;
+    if ( !lexLId( p, end, lId, "PO literal ID" ) ) return false;
+    if ( lId > maxLId ) { errInt = lId; return parseError( MAX_LIT_ID ); }
+    if ( !lexNewLine( p, end ) ) return false;
+    CirGate* newGate = createGate< CirPoGate >( outputId, ++lineNo );
     _poList.push_back( newGate );
     _totalList[ outputId++ ] = newGate;
-
-    vector< unsigned > forAllId;
-    forAllId.push_back( lId / 2 );
-    allId.push_back( forAllId );
+    setFanin( newGate, 0, lId );
   }
+  //large AND sections are parsed by all cores, any error found there is
+  //reported by parsing the section again below
+  if ( size_t( miloa[ 4 ] ) >= ParallelAigNum && myNumThreads() > 1 && 
+       readAagParallel( p, end, miloa ) )
+    return true;
   //Aig
-  //Create Gate and invert
-  for ( int i = 0 ; i < miloa[ 4 ] ; i++ ) {
-    getline( ifs, input, '\n' );
-    //get Aigate id, input id 
-    int num, flag = 0;
-    vector< int > lId;
-    string temp;
-    vector< unsigned > forAllId;
-    for ( int count = 0 ; count < 3 ; count++ ) {
-      while ( ( input[ flag ] != ' ' ) && ( flag < input.size() ) ) 
-        temp.push_back( input[ flag ++ ] );
-      myStr2Int( temp, num );
-      temp.clear();
-      lId.push_back( num );
-      forAllId.push_back( num / 2 );
-      ++flag;
+  //lId[ 0 ~ 2 ] = lhs, rhs0, rhs1
+  _aigList.reserve( miloa[ 4 ] );
+  for ( int i = 0 ; i < miloa[ 4 ] ; ++i ) {
+    unsigned lId[ 3 ];
+    if ( !lexLId( p, end, lId[ 0 ], "AIG gate literal ID" ) ) return false;
+    if ( !checkDefLId( lId[ 0 ], maxLId, "AIG gate" ) ) return false;
+    for ( int j = 1 ; j < 3 ; ++j ) {
+      if ( !lexSpace( p, end ) ) return false;
+      if ( !lexLId( p, end, lId[ j ], "AIG input literal ID" ) ) return false;
+      if ( lId[ j ] > maxLId ) { errInt = lId[ j ]; return parseError( MAX_LIT_ID ); }
     }
-    allId.push_back( forAllId );
-    allLId.push_back( lId );
-    //get invert
-    vector< bool > invert;
-    for ( int index = 1; index < 3 ; index++ )  
-      invert.push_back( lId[ index ] % 2 );
-    //create gate
-    CirGate* newGate = new CirAigGate( lId[ 0 ] / 2, invert, ++lineNo );
+    if ( !lexNewLine( p, end ) ) return false;
+    CirGate* newGate = createGate< CirAigGate >( lId[ 0 ] / 2, ++lineNo );
     _aigList.push_back( newGate );
     _totalList[ lId[ 0 ] / 2 ] = newGate;
+    setFanin( newGate, 0, lId[ 1 ] ); setFanin( newGate, 1, lId[ 2 ] );
   }
 
-  //create faninList
-  for ( int i = 0 ; i < miloa[ 3 ] ; i++ ) {
-    if ( getGate( outputLId[ i ] / 2 ) )
-      _poList[ i ]->_faninList.push_back( getGate( outputLId[ i ] / 2 ) );
-    //PO with floating fanin
-    else {
-      CirGate* newGate = new CirUndefGate( outputLId[ i ] / 2, 0 );
-      _poList[ i ]->_faninList.push_back( newGate );
-      _totalList[ outputLId[ i ] / 2 ] = newGate;
+  //floating fanins get UNDEF gates
+  for ( int i = 0 ; i < miloa[ 3 ] ; ++i )
+    getFaninGate( _poList[ i ]->fanin( 0 ).id() );
+  for ( int i = 0 ; i < miloa[ 4 ] ; ++i ) 
+    for ( int j = 0 ; j < 2 ; ++j )
+      getFaninGate( _aigList[ i ]->fanin( j ).id() );
+  createFanoutList();
+  return true;
+}
+
+// PIs are implicit( 2, 4, ... 2I ), POs are ASCII lines and the i-th AND
+// is lhs = 2( I + L + i + 1 ), rhs0 = lhs - delta0, rhs1 = rhs0 - delta1
+// Since rhs1 <= rhs0 < lhs, every fanin is defined before its fanout and
+// gates can be connected while they are created
+bool
+CirMgr::readAig( const char*& p, const char* end, const vector< int >& miloa )
+{
+  _piList.reserve( miloa[ 1 ] );
+  for ( int i = 0 ; i < miloa[ 1 ] ; ++i ) {
+    CirGate* newGate = createGate< CirPiGate >( i + 1, ++lineNo );
+    _piList.push_back( newGate );
+    _totalList[ i + 1 ] = newGate;
+  }
+  unsigned maxLId = 2 * _maxVariables + 1;
+  unsigned outputId = _maxVariables + 1;
+  _poList.reserve( miloa[ 3 ] );
+  for ( int i = 0 ; i < miloa[ 3 ] ; ++i ) {
+    unsigned lId;
+    if ( !lexLId( p, end, lId, "PO literal ID" ) ) return false;
+    if ( lId > maxLId ) { errInt = lId; return parseError( MAX_LIT_ID ); }
+    if ( !lexNewLine( p, end ) ) return false;
+    CirGate* newGate = createGate< CirPoGate >( outputId, ++lineNo );
+    _poList.push_back( newGate );
+    _totalList[ outputId++ ] = newGate;
+    setFanin( newGate, 0, lId );
+  }
+  _aigList.reserve( miloa[ 4 ] );
+  for ( int i = 0 ; i < miloa[ 4 ] ; ++i ) {
+    unsigned lhs = 2 * ( miloa[ 1 ] + i + 1 ), delta0, delta1;
+    if ( !decodeAigDelta( p, end, delta0 ) || 
+         !decodeAigDelta( p, end, delta1 ) ) {
+      errMsg = "AIG";
+      return parseError( MISSING_DEF );
+    }
+    if ( delta0 == 0 || delta0 > lhs || delta1 > lhs - delta0 ) {
+      errMsg = "AIG delta";
+      return parseError( ILLEGAL_NUM );
     }
+    unsigned rhs0 = lhs - delta0, rhs1 = rhs0 - delta1;
+    CirGate* newGate = createGate< CirAigGate >( lhs / 2, ++lineNo );
+    setFanin( newGate, 0, rhs0 ); setFanin( newGate, 1, rhs1 );
+    _aigList.push_back( newGate );
+    _totalList[ lhs / 2 ] = newGate;
   }
+  lineBegin = p;
+  createFanoutList();
+  return true;
+}
 
-  int aigPos = 0;
-  for ( int i = miloa[ 1 ] ; i < ( miloa[ 1 ] + miloa[ 4 ] ) ; i++ ) {
-    GateList fanin;
-    for ( int count = 1 ; count < 3 ; count++ ) {
-      if ( getGate( allLId[ i ][ count ] / 2 ) )  
-        fanin.push_back( getGate( allLId[ i ][ count ] / 2 ) );
-      else {
-        CirGate* newGate = new CirUndefGate( allLId[ i ][ count ]/2, 0 ); 
-        _totalList[ allLId[ i ][ count ] / 2 ] = newGate;
-        fanin.push_back( newGate );
+// same fanout order for both parsers: POs first, then AIGs in file order
+void 
+CirMgr::createFanoutList() {
+  AigParseJob job( myNumThreads() );
+  if ( _aigList.size() >= ParallelAigNum && job.nThreads > 1 ) {
+    job.edge.resize( job.nThreads * job.nThreads );
+    myParallelRun( this, &CirMgr::scatterFanout, job, job.nThreads );
+    myParallelRun( this, &CirMgr::gatherFanout, job, job.nThreads );
+    return;
+  }
+  for ( size_t i = 0, in = _poList.size() ; i < in ; ++i ) 
+    addFanout( 2 * _poList[ i ]->getId() );
+  for ( size_t i = 0, in = _aigList.size() ; i < in ; ++i ) 
+    for ( int j = 0 ; j < 2 ; ++j )
+      addFanout( 2 * _aigList[ i ]->getId() + j );
+}
+
+// append edge e to the fanout list of the gate its fanin points to
+void 
+CirMgr::addFanout( unsigned e ) {
+  unsigned g = _faninList[ e ].id(), tail = _fanoutTail[ g ];
+  _edgePrev[ e ] = tail; _edgeNext[ e ] = NoEdge;
+  if ( tail == NoEdge ) _fanoutHead[ g ] = e;
+  else                  _edgeNext[ tail ] = e;
+  _fanoutTail[ g ] = e;
+  ++_fanoutNum[ g ];
+}
+
+// unlink edge e while its fanin still points to the list owner
+void 
+CirMgr::removeFanout( unsigned e ) {
+  unsigned g = _faninList[ e ].id(), prev = _edgePrev[ e ], next = _edgeNext[ e ];
+  if ( prev == NoEdge ) _fanoutHead[ g ] = next;
+  else                  _edgeNext[ prev ] = next;
+  if ( next == NoEdge ) _fanoutTail[ g ] = prev;
+  else                  _edgePrev[ next ] = prev;
+  --_fanoutNum[ g ];
+}
+
+// The AND section is cut into one line-aligned chunk per thread. Threads
+// count the lines of their chunks, then lex and create the AIGs of them,
+// then connect their fanins. Returns false, with every AIG it created
+// deleted again, on anything the serial parser has to report.
+bool
+CirMgr::readAagParallel( const char*& p, const char* end, 
+                         const vector< int >& miloa )
+{
+  AigParseJob job( myNumThreads() );
+  size_t n = job.nThreads, size = end - p;
+  job.end = end; job.sectionEnd = 0;
+  job.aigNum = miloa[ 4 ]; job.maxLId = 2 * _maxVariables + 1;
+  job.lineBase = lineNo;
+  job.chunk.resize( n + 1 ); job.firstLine.resize( n + 1 );
+  job.chunk[ 0 ] = p; job.chunk[ n ] = end;
+  for ( size_t t = 1 ; t < n ; ++t ) {
+    const char* c = p + size * t / n;
+    while ( c != end && c[ -1 ] != '\n' ) ++c;
+    job.chunk[ t ] = ( c > job.chunk[ t - 1 ] ) ? c : job.chunk[ t - 1 ];
+  }
+  myParallelRun( this, &CirMgr::countAagLines, job, n );
+  size_t lines = 0;
+  for ( size_t t = 0 ; t <= n ; ++t ) {
+    size_t temp = job.firstLine[ t ];
+    job.firstLine[ t ] = lines;
+    lines += temp;
+  }
+  if ( lines < job.aigNum ) return false;
+  _aigList.assign( job.aigNum, NULL );
+  job.gateSlot = _gateArena.allocBlock( job.aigNum );
+  myParallelRun( this, &CirMgr::parseAagChunk, job, n );
+  bool ok = true;
+  for ( size_t t = 0 ; t < n ; ++t )
+    if ( job.fail[ t ] ) ok = false;
+  if ( !ok ) {
+    for ( size_t i = 0 ; i < job.aigNum ; ++i ) 
+      if ( _aigList[ i ] ) {
+        size_t id = _aigList[ i ]->getId();
+        _faninList[ 2 * id ] = _faninList[ 2 * id + 1 ] = CirGateV();
+        _totalList[ id ] = NULL;
+        deleteGate( _aigList[ i ] );
       }
-    }
-    _aigList[ aigPos++ ]->_faninList = fanin;
+    _aigList.clear();
+    return false;
   }
-  
-  //construct fanoutList vector< vector< unsiged > > allId
-  createFanoutList( allId, miloa[ 3 ] );
-  //create _netList, dfsTraversal
-  dfsTraversal();
-  //symbol section
-  parseSymbol( ifs );
+  for ( int i = 0 ; i < miloa[ 3 ] ; ++i )
+    getFaninGate( _poList[ i ]->fanin( 0 ).id() );
+  myParallelRun( this, &CirMgr::linkAagChunk, job, n );
+  for ( size_t t = 0 ; t < n ; ++t )
+    for ( size_t i = 0, in = job.undefAig[ t ].size() ; i < in ; ++i ) 
+      for ( int j = 0 ; j < 2 ; ++j )
+        getFaninGate( _aigList[ job.undefAig[ t ][ i ] ]->fanin( j ).id() );
+  createFanoutList();
+  lineNo += job.aigNum;
+  p = lineBegin = job.sectionEnd;
   return true;
 }
 
-void 
-CirMgr::createFanoutList( vector< vector< unsigned > > allId, int outputNum ) {
-  for ( int j = 0 ; j < allId.size() ; j ++ ) {
-    if ( j < outputNum ) { 
-      if ( getGate( allId[ j ][ 0 ] ) )
-        setFanoutList( _maxVariables +1+j, getGate( allId[ j ][ 0 ] )->getId());
+void
+CirMgr::countAagLines( AigParseJob& job, size_t t ) {
+  size_t count = 0;
+  for ( const char* c = job.chunk[ t ], *cn = job.chunk[ t + 1 ] ; 
+        ( c = ( const char* )memchr( c, '\n', cn - c ) ) ; ++c ) 
+    ++count;
+  job.firstLine[ t ] = count;
+}
+
+// lex the lines of chunk t that belong to the AND section and create the
+// AIGs; a redefinition shows up as a failed compare-and-swap on _totalList
+void
+CirMgr::parseAagChunk( AigParseJob& job, size_t t ) {
+  const char* p = job.chunk[ t ], *cn = job.chunk[ t + 1 ];
+  for ( size_t i = job.firstLine[ t ] ; i < job.aigNum && p != cn ; ++i ) {
+    unsigned lId[ 3 ];
+    if ( !lexAigLine( p, job.end, lId, job.maxLId ) ) { 
+      job.fail[ t ] = true; return; 
     }
-    else { 
-      for ( int count = 1 ; count < 3 ; count ++ )  
-        setFanoutList( allId[ j ][ 0 ],getGate( allId[ j ][ count ] )->getId());
+    CirGate* newGate = new ( job.gateSlot + i * _gateArena.slotSize() ) 
+                         CirAigGate( lId[ 0 ] / 2, job.lineBase + i + 1 );
+    if ( !__sync_bool_compare_and_swap( &_totalList[ lId[ 0 ] / 2 ], 
+                                        ( CirGate* )0, newGate ) ) {
+      newGate->~CirGate();
+      job.fail[ t ] = true; return;
+    }
+    _faninList[ lId[ 0 ] ] = lId[ 1 ]; _faninList[ lId[ 0 ] + 1 ] = lId[ 2 ];
+    _aigList[ i ] = newGate;
+    if ( i + 1 == job.aigNum ) job.sectionEnd = p;
+  }
+}
+
+// AIGs with a floating fanin are left to the caller, which creates the
+// UNDEF gates on one thread
+void
+CirMgr::linkAagChunk( AigParseJob& job, size_t t ) {
+  size_t last = ( job.firstLine[ t + 1 ] < job.aigNum ) ? 
+                job.firstLine[ t + 1 ] : job.aigNum;
+  for ( size_t i = job.firstLine[ t ] ; i < last ; ++i ) {
+    const CirGateV* in = &_faninList[ 2 * _aigList[ i ]->getId() ];
+    if ( !_totalList[ in[ 0 ].id() ] || !_totalList[ in[ 1 ].id() ] ) 
+      job.undefAig[ t ].push_back( i );
+  }
+}
+
+// Fanout edges are bucketed by the thread owning the fanin( gate ID range )
+// and then appended by their owners bucket by bucket, which keeps the order
+// of the serial loop without any two threads touching the same list.
+void
+CirMgr::scatterFanout( AigParseJob& job, size_t t ) {
+  size_t n = job.nThreads, total = _totalList.size();
+  for ( size_t i = _aigList.size() * t / n, in = _aigList.size() * ( t + 1 ) / n ; 
+        i < in ; ++i ) 
+    for ( size_t j = 0 ; j < 2 ; ++j ) {
+      size_t owner = _aigList[ i ]->fanin( j ).id() * n / total;
+      job.edge[ t * n + owner ].push_back( 2 * _aigList[ i ]->getId() + j );
     }
+}
+
+void
+CirMgr::gatherFanout( AigParseJob& job, size_t t ) {
+  size_t n = job.nThreads, total = _totalList.size();
+  for ( size_t i = 0, in = _poList.size() ; i < in ; ++i )
+    if ( _poList[ i ]->fanin( 0 ).id() * n / total == t )
+      addFanout( 2 * _poList[ i ]->getId() );
+  for ( size_t s = 0 ; s < n ; ++s ) {
+    const vector< size_t >& edge = job.edge[ s * n + t ];
+    for ( size_t i = 0, in = edge.size() ; i < in ; ++i ) 
+      addFanout( edge[ i ] );
   }
 }
 
+CirGate*
+CirMgr::getFaninGate( unsigned id ) {
+  if ( !_totalList[ id ] ) 
+    _totalList[ id ] = createGate< CirUndefGate >( id, 0 );
+  return _totalList[ id ];
+}
+
+bool
+CirMgr::checkDefLId( unsigned lId, unsigned maxLId, const char* type ) {
+  errInt = lId;
+  if ( lId > maxLId ) return parseError( MAX_LIT_ID );
+  if ( lId % 2 ) { errMsg = type; return parseError( CANNOT_INVERTED ); }
+  if ( lId / 2 == 0 ) return parseError( REDEF_CONST );
+  if ( ( errGate = getGate( lId / 2 ) ) ) return parseError( REDEF_GATE );
+  return true;
+}
+
 void 
-CirMgr::parseSymbol( ifstream& ifs ) {
-  string input;
-  getline( ifs, input, '\n' );
-  while ( input.size() > 0 ){
+CirMgr::parseSymbol( const char*& p, const char* end ) {
+  while ( p != end && *p != '\n' ) {
+    const char* eol = p;
+    while ( eol != end && *eol != '\n' ) ++eol;
+    string input( p, eol );
+    p = ( eol == end ) ? end : eol + 1;
     _symbolInput.push_back( input );
     size_t index = input.find_first_of( " " );
     string number = input.substr( 1, index - 1 );
     string symbol = input.substr( index + 1, string::npos );
 
     int id;
-    if ( myStr2Int( number, id ) ) {
-      if ( input[ 0 ] == 'i' )   
-        _piList[ id ]->setSymbolStr( symbol );
-      else if ( input[ 0 ] == 'o' )  
-        _poList[ id ]->setSymbolStr( symbol );
+    if ( myStr2Int( number, id ) && id >= 0 ) {
+      if ( input[ 0 ] == 'i' && id < _piList.size() )   
+        _symbolList[ _piList[ id ]->getId() ] = symbol;
+      else if ( input[ 0 ] == 'o' && id < _poList.size() )  
+        _symbolList[ _poList[ id ]->getId() ] = symbol;
     }
-    getline( ifs, input, '\n' );
   }
 }
 
@@ -415,7 +760,7 @@ CirMgr::printFloatGates() const
   vector< unsigned > unusedGate;
   for ( int i = 0 ; i < _totalList.size() ; ++i ) {
     if ( _totalList[ i ] ) {
-      if ( ( _totalList[ i ]->_fanoutList.size() == 0 ) && 
+      if ( ( _fanoutNum[ i ] == 0 ) && 
            ( _totalList[ i ]->gateType() != PO_GATE )   && 
            ( _totalList[ i ]->gateType() != CONST_GATE ) )
         unusedGate.push_back( _totalList[ i ]->getId() );
@@ -434,15 +779,14 @@ CirMgr::printFloatGates() const
 void
 CirMgr::printFECPairs() const
 {
-  vector< vector< unsigned > > fecPair;
-  for ( int i = 0, in = _fecGrpList.size() ; i < in ; ++i ) {
+  for ( size_t i = 0, in = fecGrpNum() ; i < in ; ++i ) {
     cout << "[" << i << "] ";
-    size_t temp;
-    for ( int j = 0, jn = _fecGrpList[ i ].size() ; j < jn ; ++j ) {
-      if ( j == 0 ) temp = _fecGrpList[ i ][ j ]->getSim();
-      if ( temp != _fecGrpList[ i ][ j ]->getSim() )
+    for ( size_t j = _fecBeginList[ i ], jn = _fecBeginList[ i + 1 ] ;
+          j < jn ; ++j ) {
+      unsigned id = _fecMemberList[ j ];
+      if ( _fecList[ id ].isInv() )
         cout << "!";
-        cout << _fecGrpList[ i ][ j ]->getId();;
+      cout << id;
       if ( j != ( jn - 1 ) )
         cout << " ";
     }
@@ -453,46 +797,104 @@ CirMgr::printFECPairs() const
 void
 CirMgr::writeAag(ostream& outfile) const
 {
+  //M is the largest variable written, not the one read
   int aigNum = 0;
+  size_t maxVar = 0;
+  for ( int i = 0 ; i < _piList.size() ; ++i ) 
+    if ( _piList[ i ]->getId() > maxVar ) maxVar = _piList[ i ]->getId();
+  for ( int i = 0 ; i < _poList.size() ; ++i ) 
+    if ( _poList[ i ]->fanin( 0 ).id() > maxVar ) 
+      maxVar = _poList[ i ]->fanin( 0 ).id();
   for ( int i = 0 ; i < _netList.size() ; ++i ) 
-    if ( _netList[ i ]->gateType() == AIG_GATE )
+    if ( _netList[ i ]->gateType() == AIG_GATE ) {
       ++aigNum;
-  outfile << "aag " << _maxVariables 
+      size_t id = _netList[ i ]->getId();
+      const CirGateV* f = &_faninList[ 2 * id ];
+      if ( id > maxVar ) maxVar = id;
+      for ( int j = 0 ; j < 2 ; ++j )
+        if ( f[ j ].id() > maxVar ) maxVar = f[ j ].id();
+    }
+  outfile << "aag " << maxVar 
           << " " << _piList.size() 
           << " 0"
           << " " << _poList.size() 
-          << " " << aigNum << endl;
+          << " " << aigNum << '\n';
   for ( int i = 0 ; i < _piList.size() ; ++i ) 
-    outfile << _piList[ i ]->getLId() << endl;
+    outfile << _piList[ i ]->getLId() << '\n';
   for ( int i = 0 ; i < _poList.size() ; ++i )  
-    outfile << _poList[ i ]->getLId() << endl;
+    outfile << _poList[ i ]->getLId() << '\n';
   for ( int i = 0 ; i < _netList.size() ; ++i ) {
     if ( _netList[ i ]->gateType() == AIG_GATE ) {
       outfile << _netList[ i ]->getLId();
-      for ( int j = 0 ; j < 2 ; ++j ) {
-        if ( _netList[ i ]->invert( j ) )
-          outfile << " " << _netList[ i ]->_faninList[ j ]->getLId() + 1;
-        else 
-          outfile << " " << _netList[ i ]->_faninList[ j ]->getLId();
-      }
-      outfile << endl;
+      for ( int j = 0 ; j < 2 ; ++j )
+        outfile << " " << _faninList[ 2 * _netList[ i ]->getId() + j ].lId();
+      outfile << '\n';
     }
   }
   for ( int i = 0 ; i < _symbolInput.size() ; ++i )
-    outfile << _symbolInput[ i ] << endl;
-  outfile << 'c' << endl;
+    outfile << _symbolInput[ i ] << '\n';
+  outfile << 'c' << '\n';
   outfile << "AAG output by Shun-Yao ( Gary ) Shih" << endl;
 }
 
+// Variables are renumbered as PIs( 1 ~ I ) followed by the AIGs in _netList
+// order, so every AND is defined after its fanins as binary AIGER requires.
+// UNDEF fanins have no variable in the binary format and are written as
+// const 0, which is also what they simulate to.
+void
+CirMgr::writeAig(ostream& outfile) const
+{
+  vector< unsigned > newLId( _totalList.size(), 0 );
+  unsigned varNum = 0;
+  for ( size_t i = 0, in = _piList.size() ; i < in ; ++i )
+    newLId[ _piList[ i ]->getId() ] = 2 * ( ++varNum );
+  for ( size_t i = 0, in = _netList.size() ; i < in ; ++i )
+    if ( _netList[ i ]->gateType() == AIG_GATE )
+      newLId[ _netList[ i ]->getId() ] = 2 * ( ++varNum );
+  string buf;
+  buf.reserve( 16 * _poList.size() + 4 * ( varNum - _piList.size() ) + 64 );
+  buf += "aig "; appendUInt( buf, varNum );
+  buf += ' ';    appendUInt( buf, _piList.size() );
+  buf += " 0 ";  appendUInt( buf, _poList.size() );
+  buf += ' ';    appendUInt( buf, varNum - _piList.size() );
+  buf += '\n';
+  for ( size_t i = 0, in = _poList.size() ; i < in ; ++i ) {
+    CirGate* g = _poList[ i ];
+    CirGateV f = _faninList[ 2 * g->getId() ];
+    appendUInt( buf, newLId[ f.id() ] + f.isInv() );
+    buf += '\n';
+  }
+  for ( size_t i = 0, in = _netList.size() ; i < in ; ++i ) {
+    CirGate* g = _netList[ i ];
+    if ( g->gateType() != AIG_GATE ) continue;
+    const CirGateV* f = &_faninList[ 2 * g->getId() ];
+    unsigned lhs = newLId[ g->getId() ],
+             rhs0 = newLId[ f[ 0 ].id() ] + f[ 0 ].isInv(),
+             rhs1 = newLId[ f[ 1 ].id() ] + f[ 1 ].isInv();
+    if ( rhs0 < rhs1 ) { unsigned temp = rhs0; rhs0 = rhs1; rhs1 = temp; }
+    encodeAigDelta( buf, lhs - rhs0 );
+    encodeAigDelta( buf, rhs0 - rhs1 );
+  }
+  for ( size_t i = 0, in = _symbolInput.size() ; i < in ; ++i ) {
+    buf += _symbolInput[ i ];
+    buf += '\n';
+  }
+  buf += "c\nAIG output by Shun-Yao ( Gary ) Shih\n";
+  outfile.write( buf.data(), buf.size() );
+  outfile.flush();
+}
+
 bool
 comparePi( CirGate* a, CirGate* b ) { return ( a->getId() < b->getId() ); }
 void
 CirMgr::writeGate(ostream& outfile, CirGate *g) const
 {
-  vector< CirGate* > pi, aig;
+  vector< CirGate* > pi, aig, cone;
   vector< string > symbol;
-  CirGate::setGlobalRef();
-  writedfs( g, pi, aig );
+  dfsOrder( GateList( 1, g ), cone );
+  for ( size_t i = 0, in = cone.size() ; i < in ; ++i )
+    if ( cone[ i ]->gateType() == PI_GATE ) pi.push_back( cone[ i ] );
+    else aig.push_back( cone[ i ] );
   outfile << "aag " << _maxVariables << " " << pi.size() << " 0 1 " << aig.size() << endl;;
   sort( pi.begin(), pi.end(), comparePi );
   for ( size_t i = 0, in = pi.size() ; i < in ; ++i ) 
@@ -500,12 +902,8 @@ CirMgr::writeGate(ostream& outfile, CirGate *g) const
   outfile << g->getId() * 2 << endl;
   for ( size_t i = 0, in = aig.size() ; i < in ; ++i ) {
     outfile << aig[ i ]->getId() * 2;
-    for ( size_t j = 0 ; j < 2 ; ++j ) {
-      if ( aig[ i ]->invert( j ) )
-        outfile << " " << aig[ i ]->_faninList[ j ]->getId() * 2 + 1;
-      else 
-        outfile << " " << aig[ i ]->_faninList[ j ]->getId() * 2;
-    }
+    for ( size_t j = 0 ; j < 2 ; ++j )
+      outfile << " " << aig[ i ]->fanin( j ).lId();
     outfile << endl;
   }
   for ( size_t i = 0, in = pi.size() ; i < in ; ++i )
@@ -517,26 +915,16 @@ CirMgr::writeGate(ostream& outfile, CirGate *g) const
   outfile << "Write gate (" << g->getId() << ") by Shun-Yao ( Gary ) Shih" << endl;
 }
 
-void 
-CirMgr::writedfs( CirGate* g, vector< CirGate* >& pi, vector< CirGate* >& aig ) const {
-  g->setToGlobalRef();
-  for ( size_t i = 0 ; i < g->_faninList.size() ; i++ ) {
-    if ( !( g->_faninList[ i ] )->isGlobalRef() && 
-          ( g->_faninList[ i ] )->gateType() != UNDEF_GATE )
-      writedfs( g->_faninList[ i ], pi, aig );
-  }
-  if ( g->gateType() == PI_GATE ) pi.push_back( g );
-  else aig.push_back( g );
-}
 vector< int >
-CirMgr::MILOA( const string& input ) {
+CirMgr::MILOA( const string& input, bool& binary ) {
   //errorhandling 2.
   vector< int > empty;
   myStrGetTok( input, errMsg );
-  if ( errMsg != "aag" ) { 
+  if ( errMsg != "aag" && errMsg != "aig" ) { 
     parseError( ILLEGAL_IDENTIFIER );
     return empty;
   }
+  binary = ( errMsg == "aig" );
   //if ( !detectExtraSpace( input ) ) return empty;
   //read Line 1.
   string temp;
@@ -579,54 +967,237 @@ CirMgr::MILOA( const string& input ) {
     parseError( NUM_TOO_SMALL );
     return empty;
   }
+  //binary AIGER has no room for latches or unused variables
+  if ( binary && miloa[ 2 ] != 0 ) {
+    errMsg = "Number of latches";
+    errInt = miloa[ 2 ];
+    parseError( NUM_TOO_BIG );
+    return empty;
+  }
+  if ( binary && miloa[ 0 ] != ( miloa[ 1 ] + miloa[ 4 ] ) ) {
+    errMsg = "Num of variables";
+    errInt = miloa[ 0 ];
+    parseError( NUM_TOO_BIG );
+    return empty;
+  }
   return miloa;
 }
 
 void 
 CirMgr::dfsTraversal() {
   _netList.clear();
-  CirGate::setGlobalRef();
-  for ( int i = 0, in = _poList.size() ; i < in ; i++ ) {
-    for ( int j = 0, jn = _poList[ i ]->faninSize() ; j < jn ; j++ ) {
-      if ( ! (_poList[ i ]->_faninList[ j ])->isGlobalRef() && 
-             (_poList[ i ]->_faninList[ j ])->gateType() != UNDEF_GATE )
-        dfsTraversal( _poList[ i ]->_faninList[ j ] );
+  dfsOrder( _poList, _netList );
+  rankNetList();
+}
+
+void 
+CirMgr::rankNetList() {
+  _simProgram.clear();
+  _rankList.assign( _totalList.size(), NoRank );
+  for ( size_t i = 0, in = _netList.size() ; i < in ; ++i )
+    _rankList[ _netList[ i ]->getId() ] = i;
+}
+
+// Drops the NULL slots left in _netList by deleteGate()
+void 
+CirMgr::compactNetList() {
+  size_t n = 0;
+  for ( size_t i = 0, in = _netList.size() ; i < in ; ++i )
+    if ( _netList[ i ] ) _netList[ n++ ] = _netList[ i ];
+  _netList.resize( n );
+  rankNetList();
+}
+
+// Called before the fanouts of "tempGate" are moved to "newGate". If one
+// of them comes before "newGate" in _netList, the slots between them are
+// reordered as in Pearce and Kelly's dynamic topological sort: the fanin
+// cone of "newGate" and the fanout cone of the moved gates, both cut to
+// that range, swap places. Returns false if the merge would close a loop,
+// the order is not touched then.
+bool 
+CirMgr::keepOrder( CirGate* newGate, CirGate* tempGate ) {
+  unsigned ub = _rankList[ newGate->getId() ], lb = NoRank;
+  if ( newGate->faninSize() == 0 ) return true;
+  if ( ub == NoRank ) return false;
+  size_t tempId = tempGate->getId();
+  for ( unsigned e = _fanoutHead[ tempId ] ; e != NoEdge ; e = _edgeNext[ e ] )
+    if ( _rankList[ e / 2 ] < lb ) lb = _rankList[ e / 2 ];
+  if ( lb == NoRank || lb > ub ) return true;
+
+  GateList fwd, bwd, stack;
+  _orderMark.start( _totalList.size() );
+  for ( unsigned e = _fanoutHead[ tempId ] ; e != NoEdge ; e = _edgeNext[ e ] ) {
+    CirGate* g = _totalList[ e / 2 ];
+    if ( _rankList[ g->getId() ] < ub && !_orderMark.isMarked( g->getId() ) ) {
+      _orderMark.mark( g->getId() ); stack.push_back( g );
     }
-    _netList.push_back( _poList[ i ] );
-    _poList[ i ]->setToGlobalRef();
   }
+  while ( !stack.empty() ) {
+    CirGate* g = stack.back(); stack.pop_back();
+    fwd.push_back( g );
+    for ( unsigned e = _fanoutHead[ g->getId() ] ; e != NoEdge ; 
+          e = _edgeNext[ e ] ) {
+      CirGate* fo = _totalList[ e / 2 ];
+      if ( fo == newGate ) return false;
+      if ( _rankList[ e / 2 ] < ub && !_orderMark.isMarked( e / 2 ) ) {
+        _orderMark.mark( e / 2 ); stack.push_back( fo );
+      }
+    }
+  }
+  _orderMark.mark( newGate->getId() ); stack.push_back( newGate );
+  while ( !stack.empty() ) {
+    CirGate* g = stack.back(); stack.pop_back();
+    bwd.push_back( g );
+    for ( int i = 0, in = g->faninSize() ; i < in ; ++i ) {
+      CirGate* fi = g->faninGate( i );
+      unsigned r = _rankList[ fi->getId() ];
+      if ( r != NoRank && r > lb && !_orderMark.isMarked( fi->getId() ) ) {
+        _orderMark.mark( fi->getId() ); stack.push_back( fi );
+      }
+    }
+  }
+  // the freed slots, lowest first, take bwd then fwd, each in old order
+  IdList slots;
+  for ( size_t i = 0, in = bwd.size() ; i < in ; ++i ) 
+    slots.push_back( _rankList[ bwd[ i ]->getId() ] );
+  for ( size_t i = 0, in = fwd.size() ; i < in ; ++i ) 
+    slots.push_back( _rankList[ fwd[ i ]->getId() ] );
+  sort( slots.begin(), slots.end() );
+  sort( bwd.begin(), bwd.end(), RankLess( _rankList ) );
+  sort( fwd.begin(), fwd.end(), RankLess( _rankList ) );
+  bwd.insert( bwd.end(), fwd.begin(), fwd.end() );
+  _simProgram.clear();
+  for ( size_t i = 0, in = slots.size() ; i < in ; ++i ) {
+    _netList[ slots[ i ] ] = bwd[ i ];
+    _rankList[ bwd[ i ]->getId() ] = slots[ i ];
+  }
+  return true;
 }
+
+// Appends every gate reachable from "roots" to "order" in DFS post-order,
+// so the fanins of a gate come before it ( its fanouts with "byFanout" ).
+// Undefined gates are skipped. The explicit stack holds the gate and the
+// next child to visit, a fanin index or a fanout edge, so deep circuits
+// cannot overflow the call stack. The marks are local, so calls on
+// separate threads can run at once.
 void 
-CirMgr::dfsTraversal( CirGate* child ) 
+CirMgr::dfsOrder( const GateList& roots, GateList& order, bool byFanout ) const
 {
-  child->setToGlobalRef();
-  for ( int i = 0 ; i < child->_faninList.size() ; i++ ) {
-    if ( ! (child->_faninList[ i ])->isGlobalRef() && 
-           (child->_faninList[ i ])->gateType() != UNDEF_GATE )
-      dfsTraversal( child->_faninList[ i ] );
+  vector< pair< CirGate*, unsigned > > stack;
+  CirMark mark( _totalList.size() );
+  for ( size_t r = 0, rn = roots.size() ; r < rn ; ++r ) {
+    if ( mark.isMarked( roots[ r ]->getId() ) ) continue;
+    mark.mark( roots[ r ]->getId() );
+    stack.push_back( make_pair( roots[ r ], byFanout ? 
+                                _fanoutHead[ roots[ r ]->getId() ] : 0u ) );
+    while ( !stack.empty() ) {
+      CirGate* g = stack.back().first;
+      unsigned& next = stack.back().second;
+      CirGate* child = 0;
+      while ( !child ) {
+        CirGate* c;
+        if ( byFanout ) {
+          if ( next == NoEdge ) break;
+          c = _totalList[ next / 2 ]; next = _edgeNext[ next ];
+        }
+        else {
+          if ( next == ( unsigned )g->faninSize() ) break;
+          c = g->faninGate( next++ );
+        }
+        if ( !mark.isMarked( c->getId() ) && c->gateType() != UNDEF_GATE ) 
+          child = c;
+      }
+      if ( child ) {
+        mark.mark( child->getId() );
+        stack.push_back( make_pair( child, byFanout ? 
+                                    _fanoutHead[ child->getId() ] : 0u ) );
+      }
+      else {
+        order.push_back( g );
+        stack.pop_back();
+      }
+    }
   }
-  _netList.push_back( child );
 }
 
+// level of every gate in _netList, the longest path from a PI or CONST
 void 
-CirMgr::setFanoutList( unsigned parent, unsigned child ) {
-  CirGate* fanout = getGate( parent );
-  CirGate* gate = getGate( child );
-  gate->_fanoutList.push_back( fanout );
+CirMgr::computeLevel() {
+  for ( size_t i = 0, in = _netList.size() ; i < in ; ++i ) {
+    size_t id = _netList[ i ]->getId();
+    const CirGateV* f = &_faninList[ 2 * id ];
+    if ( f[ 0 ].isNull() ) _levelList[ id ] = 0;
+    else {
+      unsigned l0 = _levelList[ f[ 0 ].id() ], l1 = _levelList[ f[ 1 ].id() ];
+      _levelList[ id ] = ( ( l0 > l1 ) ? l0 : l1 ) + 1;
+    }
+  }
 }
 
 void 
 CirMgr::createConstGate() {
-  CirGate* newGate = new CirConstGate( 0, 0 );
-  _totalList[ 0 ] = newGate;
+  _totalList[ 0 ] = createGate< CirConstGate >( 0, 0 );
+}
+
+// one entry per _totalList slot
+void
+CirMgr::initStore() {
+  size_t n = _totalList.size();
+  _faninList.assign( 2 * n, CirGateV() );
+  _simList.assign( n * SimWords, 0 );
+  _simWord = 0;
+  _simStale = false;
+  _simTuned = 0;
+  _levelList.assign( n, 0 );
+  _varList.assign( n, 0 );
+  _symbolList.assign( n, string() );
+  _fecList.assign( n, CirGateV() );
+  _rankList.assign( n, NoRank );
+  _fanoutHead.assign( n, NoEdge );
+  _fanoutTail.assign( n, NoEdge );
+  _fanoutNum.assign( n, 0 );
+  _edgeNext.assign( 2 * n, NoEdge );
+  _edgePrev.assign( 2 * n, NoEdge );
+}
+
+void
+CirMgr::deleteGate( CirGate* g ) {
+  unsigned& rank = _rankList[ g->getId() ];
+  if ( rank != NoRank ) { 
+    _netList[ rank ] = NULL; rank = NoRank; _simProgram.clear(); 
+  }
+  g->~CirGate();
+  _gateArena.free( g );
+}
+
+void
+CirMgr::setFanin( CirGate* g, int i, CirGateV v ) {
+  size_t id = g->getId();
+  _simProgram.clear();
+  _faninList[ 2 * id + i ] = v;
+  if ( g->gateType() == PO_GATE ) _faninList[ 2 * id + 1 ] = v;
 }
 
 void 
 CirMgr::clear() {
-   for ( int i = 0 ; i < _totalList.size() ; i ++ ) 
-     if ( _totalList[ i ] )
-       delete _totalList[ i ];
+   //gates own no memory, their arena blocks go without any destructor
+   _gateArena.release();
+   _totalList.clear(); _piList.clear(); _poList.clear();
+   _aigList.clear(); _netList.clear();
+   vector< CirGateV >().swap( _faninList );
+   vector< unsigned long long >().swap( _simList );
+   IdList().swap( _levelList );
+   vector< Var >().swap( _varList );
+   vector< string >().swap( _symbolList );
+   vector< CirGateV >().swap( _fecList );
+   IdList().swap( _rankList );
+   vector< CirSimOp >().swap( _simProgram );
+   IdList().swap( _simLevelBegin );
+   IdList().swap( _fanoutHead ); IdList().swap( _fanoutTail );
+   IdList().swap( _fanoutNum );
+   IdList().swap( _edgeNext ); IdList().swap( _edgePrev );
    vector< string >().swap( _symbolInput );
-   _fecGrpList.clear();
+   IdList().swap( _fecMemberList );
+   IdList().swap( _fecBeginList );
 }
 
@@ -13,6 +13,7 @@
 #include <string>
 #include <fstream>
 #include <iostream>
+#include <new>
 
 using namespace std;
 
@@ -20,31 +21,73 @@ using namespace std;
 
 #include "cirDef.h"
 #include "sat.h"
+#include "myArena.h"
 
 extern CirMgr *cirMgr;
 
+struct AigParseJob;
+struct SimLevelJob;
+struct SimBlockJob;
+class SimTable;
+struct SimPatternBatch;
+struct SimPatternJob;
+struct SimPackedFile;
+
 class CirMgr
 {
   friend class WrapperGate;
 public:
-   CirMgr() {}
+   CirMgr();
    ~CirMgr() { clear(); } 
 
    // Access functions
    // return '0' if "gid" corresponds to an undefined gate.
    CirGate* getGate(unsigned gid) const { return _totalList[ gid ]; }
+   // gate ids are below this, size a CirMark with it
+   size_t getTotalSize() const { return _totalList.size(); }
+   // the last 64 patterns simulated; getSimBlock() has all SimWords words
+   unsigned long long getSim(unsigned gid) const { 
+      return _simList[ gid * SimWords + _simWord ]; }
+   const unsigned long long* getSimBlock(unsigned gid) const { 
+      return &_simList[ gid * SimWords ]; }
+   Var getVar(unsigned gid) const { return _varList[ gid ]; }
+   CirGateV getFanin(unsigned gid, int i) const { 
+      return _faninList[ 2 * gid + i ]; }
+   const string& getSymbol(unsigned gid) const { return _symbolList[ gid ]; }
+   // fanout edge e is fanin e % 2 of gate e / 2
+   unsigned getFanoutNum(unsigned gid) const { return _fanoutNum[ gid ]; }
+   unsigned getFanoutHead(unsigned gid) const { return _fanoutHead[ gid ]; }
+   unsigned getNextFanout(unsigned e) const { return _edgeNext[ e ]; }
+   static const unsigned NoEdge = ~0u;
+   CirGateV getFecGrp(unsigned gid) const { return _fecList[ gid ]; }
+   size_t getFecGrpSize(size_t grp) const {
+      return _fecBeginList[ grp + 1 ] - _fecBeginList[ grp ]; }
+   unsigned getFecMember(size_t grp, size_t i) const {
+      return _fecMemberList[ _fecBeginList[ grp ] + i ]; }
 
    // Member functions about circuit construction
    bool readCircuit(const string&);
+   bool loadSnapshot(const string&, unsigned&);
 
    // Member functions about circuit optimization
    void sweep();
    void optimize();
+   void compact();
 
    // Member functions about simulation
    void randomSim();
-   void fileSim(ifstream&);
+   // text patterns, or packed ones if the file starts with their magic
+   void fileSim(ifstream&, const string&);
+   bool isPackedPatternFile(ifstream&) const;
    void setSimLog(ofstream *logFile) { _simLog = logFile; }
+   // 0 to let simulate() measure the fastest count
+   void setSimThreads(size_t n) { _simThreads = n; }
+   // random blocks restart from stream 0 of the seed
+   void setSimSeed(unsigned long long s) { _simSeed = s; _simRound = 0; }
+   // random simulation stops once blocks eliminate at most a gain share
+   // of the FEC candidates, or after seconds of wall time if > 0
+   void setSimGain(double gain) { _simGain = gain; }
+   void setSimTimeLimit(double seconds) { _simTimeLimit = seconds; }
 
    // Member functions about fraig
    void strash();
@@ -59,10 +102,21 @@ public:
    void printFloatGates() const;
    void printFECPairs() const;
    void writeAag(ostream&) const;
+   void writeAig(ostream&) const;
    void writeGate(ostream&, CirGate*) const;
+   bool saveSnapshot(const string&, unsigned) const;
 
 private:
    ofstream           *_simLog;
+   size_t              _simThreads;
+   // thread count simulate() measured as fastest, 0 before it is measured
+   size_t              _simTuned;
+   // block k of random simulation takes stream k of _simSeed; _simRound
+   // blocks have been taken so far
+   unsigned long long  _simSeed;
+   size_t              _simRound;
+   double              _simGain;
+   double              _simTimeLimit;
 
    GateList _piList;
    GateList _poList;
@@ -76,19 +130,85 @@ private:
    int _maxVariables;
    vector< string > _symbolInput;
 
-   vector< GateList > _fecGrpList;
+   // FEC groups, each one held once. The gate ids of group g are
+   // _fecMemberList[ _fecBeginList[ g ] ] up to _fecBeginList[ g + 1 ].
+   IdList _fecMemberList;
+   IdList _fecBeginList;
+   // work lists of refineFec(), kept to save allocations every round
+   IdList _fecSlot, _fecGrpOf, _fecGrpPos, _fecTemp, _fecNewBegin;
+
+   // Struct-of-arrays store indexed by gate id. Simulation, strash and
+   // fraig run on these dense arrays only. _faninList[ 2 * id + i ] is the
+   // only copy of the fanins; a PO has both entries set to its fanin and
+   // gates without fanins have null ones. _simList holds SimWords words
+   // per gate from _simList[ SimWords * id ]; the last pass put its last
+   // patterns in word _simWord. While _simStale, only the PIs and the
+   // FEC cones hold that pass.
+   vector< CirGateV >             _faninList;
+   vector< unsigned long long >   _simList;
+   size_t                         _simWord;
+   bool                           _simStale;
+   IdList                         _levelList;
+   vector< Var >                  _varList;
+   vector< string >               _symbolList;
+   // CirGateV( group, inv ), inv if the sim value is the inverse of the
+   // first member's; null if the gate is in no FEC group
+   vector< CirGateV >             _fecList;
+   // position in _netList, kept up to date by fraig merges
+   IdList                         _rankList;
+   // marks of keepOrder(), reused so a merge costs only its affected cone
+   CirMark                        _orderMark;
+   // _netList lowered for simulate(), built on demand and cleared by every
+   // change of _netList or of a fanin. The ops are sorted by logic level;
+   // level l is _simProgram[ _simLevelBegin[ l ] ] up to the next begin.
+   vector< CirSimOp >             _simProgram;
+   IdList                         _simLevelBegin;
+   // marks of lowerFecCones(), reused so a late resimulation costs only
+   // the cones of the FEC groups left
+   CirMark                        _coneMark;
+   // Fanouts as doubly-linked lists threaded through the fanin slots:
+   // edge 2 * id + i, fanin i of gate id, sits in the list of the gate it
+   // points to and is unlinked in O(1). Heads and counts are per gate id,
+   // links per fanin slot.
+   IdList                         _fanoutHead;
+   IdList                         _fanoutTail;
+   IdList                         _fanoutNum;
+   IdList                         _edgeNext;
+   IdList                         _edgePrev;
+
+   // every gate lives in a slot of _gateArena, see createGate()/deleteGate()
+   MyArena                        _gateArena;
 
-   vector< int > MILOA( const string& );
-   void createFanoutList( vector< vector< unsigned > >, int );
-   void parseSymbol( ifstream& );
+   vector< int > MILOA( const string&, bool& );
+   bool readAag( const char*&, const char*, const vector< int >& );
+   bool readAig( const char*&, const char*, const vector< int >& );
+   void createFanoutList();
+   void addFanout( unsigned );
+   void removeFanout( unsigned );
+   bool readAagParallel( const char*&, const char*, const vector< int >& );
+   void countAagLines( AigParseJob&, size_t );
+   void parseAagChunk( AigParseJob&, size_t );
+   void linkAagChunk( AigParseJob&, size_t );
+   void scatterFanout( AigParseJob&, size_t );
+   void gatherFanout( AigParseJob&, size_t );
+   CirGate* getFaninGate( unsigned );
+   bool checkDefLId( unsigned, unsigned, const char* );
+   void parseSymbol( const char*&, const char* );
 
    void dfsTraversal();
-   void dfsTraversal( CirGate* );
+   void dfsOrder( const GateList&, GateList&, bool = false ) const;
+   void computeLevel();
+   void rankNetList();
+   void compactNetList();
+   bool keepOrder( CirGate*, CirGate* );
    void createConstGate();
-   void setFanoutList( unsigned, unsigned );
+   template < class T > CirGate* createGate( size_t id, unsigned lineNo ) {
+      return new ( _gateArena.alloc() ) T( id, lineNo ); }
+   void deleteGate( CirGate* );
+   void initStore();
+   void setFanin( CirGate*, int, CirGateV );
    void clear();
    //sweep, optimize
-   void clearUnusedFanout( CirGate* );
    void aigOptConstFanin( CirGate*, int );
    void aigOptSameFanin( CirGate* ); 
    void inverseFanoutInvert( CirGate* );
@@ -98,19 +218,40 @@ private:
    //vector< unsigned long long > toHashKey( CirGate* );
 
    //simulate
-   void determineMaxFail();
-   void createRandomSim();
+   bool stopRandomSim( SimBlockJob& ) const;
+   void createRandomSim( size_t, unsigned long long* ) const;
    void simulate();
+   void simulate( size_t );
+   void tuneSimThreads( size_t );
+   void lowerNetList();
+   void lowerFecCones( vector< CirSimOp >& );
+   void simulateLevels( SimLevelJob&, size_t );
+   size_t simBlockNum() const;
+   void prepareSimBlocks( SimBlockJob& );
+   bool simulateBlocks( SimBlockJob& );
+   void simulateBlock( SimBlockJob&, size_t );
+   void copyConeSim( const vector< unsigned long long >&, 
+                     const vector< CirSimOp >& );
+   void loadSimBlock( SimBlockJob&, size_t ) const;
+   void writeLog( SimBlockJob&, size_t );
+   void packedFileSim( const string& );
+   void simulateWords( const vector< vector< unsigned long long > >&, size_t );
    void initFecGrp();
-   void identifyFEC();
-   void outputFile( vector< string >& , size_t& );
-   bool checkErr( vector< string > );
-   void stringToSim( vector< string >& , size_t& );
+   void labelFec( const unsigned long long*, IdList&, SimTable& ) const;
+   void refineFec( const IdList& );
+   void formatLog( const vector< string >&, size_t, 
+                   const unsigned long long*, string& ) const;
+   void readPatterns( SimPatternJob&, size_t );
+   bool packPattern( const string&, SimPatternJob&, SimPatternBatch& ) const;
+   void flushPatterns( SimPatternJob&, SimPatternBatch& ) const;
    void sortFecGrp();
    void assignFecGrp();
+   size_t fecGrpNum() const { 
+      return _fecBeginList.empty() ? 0 : _fecBeginList.size() - 1; }
+   void popFecGrp();
 
    void genProofModel( SatSolver& );
-   bool proofFecGrp( SatSolver&, vector< CirGate* >&, size_t& );
+   bool proofFecGrp( SatSolver&, size_t, size_t& );
    void arrangeFecGrp( vector< CirGate* >&, vector< bool >& );
    bool proofFecPair( SatSolver&, CirGate*, CirGate*, bool = false );
    bool proofConstPair( SatSolver&, CirGate*, bool = false );
@@ -121,7 +262,6 @@ private:
    void resetSatPattern();
    void resimulate( size_t& );
 
-   void writedfs( CirGate*, vector< CirGate* >&, vector< CirGate* >& ) const;
    //speed up
    void sortFecGrpList();
    bool proofSATGrp( SatSolver&, vector< CirGate* >& );
@@ -7,6 +7,7 @@
 ****************************************************************************/
 
 #include <cassert>
+#include <algorithm>
 #include "cirMgr.h"
 #include "cirGate.h"
 #include "util.h"
@@ -33,29 +34,106 @@ using namespace std;
 void
 CirMgr::sweep()
 {
-  CirGate::setGlobalRef();
-  _totalList[ 0 ]->setToGlobalRef();
+  CirMark used( _totalList.size() );
+  used.mark( 0 );
   for ( int i = 0, n = _netList.size() ; i < n ; ++i ) 
-    _netList[ i ]->setToGlobalRef();
+    used.mark( _netList[ i ]->getId() );
   for ( int i = 0, in = _piList.size() ; i < in ; ++i )
-    _piList[ i ]->setToGlobalRef();
+    used.mark( _piList[ i ]->getId() );
   for ( int i = 0, tn = _totalList.size() ; i < tn ; ++i ) {
     if ( _totalList[ i ] ) {
-      if ( !_totalList[ i ]->isGlobalRef() ) {
-        _totalList[ i ]->_fanoutList.clear();
-        for ( int j = 0 ; j < _totalList[ i ]->faninSize() ; ++j ) {
-          if ( _totalList[ i ]->_faninList[ j ]->isGlobalRef() )
-            clearUnusedFanout( _totalList[ i ]->_faninList[ j ] );
-        }
-        _totalList[ i ]->_faninList.clear();
+      if ( !used.isMarked( i ) ) {
+        //unlink even from fanins swept already, their lists are kept
+        //for a referenced UNDEF gate that compact() brings back
+        for ( int j = 0 ; j < _totalList[ i ]->faninSize() ; ++j )
+          removeFanout( 2 * i + j );
+        _faninList[ 2 * i ] = _faninList[ 2 * i + 1 ] = CirGateV();
         cout << "Sweeping: " << _totalList[ i ]->getTypeStr() 
              << "(" << _totalList[ i ]->getId() << ") removed..." << endl;
-        delete _totalList[ i ];
+        deleteGate( _totalList[ i ] );
         _totalList[ i ] = NULL;
       }
     }
   }
 }
+static inline unsigned
+remapEdge( unsigned e, const IdList& newId ) {
+  return e == CirMgr::NoEdge ? e : 2 * newId[ e / 2 ] + e % 2;
+}
+
+// Renumber the live gates densely: CONST 0, the PIs in _piList order, the
+// UNDEF gates, the AIGs in DFS order ( the unreachable ones after the
+// netlist ) and the POs from M + 1. _totalList loses its holes, every store
+// column is remapped and M becomes the number of variables left.
+void
+CirMgr::compact()
+{
+  //sweep may have removed UNDEF gates that are still referenced
+  for ( size_t i = 0, n = _totalList.size() ; i < n ; ++i )
+    if ( _totalList[ i ] )
+      for ( int j = 0, jn = _totalList[ i ]->faninSize() ; j < jn ; ++j )
+        getFaninGate( _totalList[ i ]->fanin( j ).id() );
+
+  GateList order( 1, _totalList[ 0 ] ), roots( _poList ), cone;
+  order.insert( order.end(), _piList.begin(), _piList.end() );
+  for ( size_t i = 0, n = _totalList.size() ; i < n ; ++i ) {
+    if ( !_totalList[ i ] ) continue;
+    if ( _totalList[ i ]->gateType() == UNDEF_GATE ) 
+      order.push_back( _totalList[ i ] );
+    else if ( _totalList[ i ]->gateType() == AIG_GATE ) 
+      roots.push_back( _totalList[ i ] );
+  }
+  dfsOrder( roots, cone );
+  for ( size_t i = 0, n = cone.size() ; i < n ; ++i )
+    if ( cone[ i ]->gateType() == AIG_GATE ) order.push_back( cone[ i ] );
+  unsigned maxVar = order.size() - 1;
+  order.insert( order.end(), _poList.begin(), _poList.end() );
+
+  size_t n = order.size();
+  IdList newId( _totalList.size(), 0 );
+  for ( size_t i = 0 ; i < n ; ++i ) newId[ order[ i ]->getId() ] = i;
+  vector< CirGateV > fanin( 2 * n );
+  vector< unsigned long long > sim( n * SimWords );
+  IdList level( n );
+  vector< Var > var( n );
+  vector< string > symbol( n );
+  IdList head( n ), tail( n ), num( n ), next( 2 * n ), prev( 2 * n );
+  for ( size_t i = 0 ; i < n ; ++i ) {
+    size_t id = order[ i ]->getId();
+    head[ i ] = remapEdge( _fanoutHead[ id ], newId );
+    tail[ i ] = remapEdge( _fanoutTail[ id ], newId );
+    num[ i ] = _fanoutNum[ id ];
+    for ( int j = 0 ; j < 2 ; ++j ) {
+      next[ 2 * i + j ] = remapEdge( _edgeNext[ 2 * id + j ], newId );
+      prev[ 2 * i + j ] = remapEdge( _edgePrev[ 2 * id + j ], newId );
+    }
+    for ( int j = 0 ; j < 2 ; ++j ) {
+      CirGateV f = _faninList[ 2 * id + j ];
+      if ( !f.isNull() ) fanin[ 2 * i + j ] = CirGateV( newId[ f.id() ], f.isInv() );
+    }
+    copy( _simList.begin() + SimWords * id, 
+          _simList.begin() + SimWords * ( id + 1 ), sim.begin() + SimWords * i );
+    level[ i ] = _levelList[ id ];
+    var[ i ] = _varList[ id ];
+    symbol[ i ].swap( _symbolList[ id ] );
+    order[ i ]->_gateId = i;
+  }
+  _totalList.swap( order );
+  _faninList.swap( fanin );
+  _simList.swap( sim );
+  _levelList.swap( level );
+  _varList.swap( var );
+  _symbolList.swap( symbol );
+  _fanoutHead.swap( head ); _fanoutTail.swap( tail ); _fanoutNum.swap( num );
+  _edgeNext.swap( next ); _edgePrev.swap( prev );
+  rankNetList();
+  for ( size_t i = 0, in = _fecMemberList.size() ; i < in ; ++i )
+    _fecMemberList[ i ] = newId[ _fecMemberList[ i ] ];
+  sortFecGrp();
+  assignFecGrp();
+  _maxVariables = maxVar;
+}
+
 // Recursively simplifying from POs;
 // _dfsList needs to be reconstructed afterwards
 // UNDEF gates may be delete if its fanout becomes empty...
@@ -64,11 +142,11 @@ CirMgr::optimize()
 {
   for ( int i = 0, n = _netList.size() ; i < n ; ++i ) {
     if ( _netList[ i ]->gateType() == AIG_GATE ) {
-      if ( _netList[ i ]->_faninList[ 0 ]->gateType() == CONST_GATE ) 
+      if ( _netList[ i ]->faninType( 0 ) == CONST_GATE ) 
         aigOptConstFanin( _netList[ i ], 0 );
-      else if ( _netList[ i ]->_faninList[ 1 ]->gateType() == CONST_GATE )
+      else if ( _netList[ i ]->faninType( 1 ) == CONST_GATE )
         aigOptConstFanin( _netList[ i ], 1 );
-      else if ( _netList[ i ]->_faninList[0] == _netList[ i ]->_faninList[1] ) {
+      else if ( _netList[ i ]->fanin( 0 ).id() == _netList[ i ]->fanin( 1 ).id() ) {
         aigOptSameFanin( _netList[ i ] );
       }
     }
@@ -79,23 +157,13 @@ CirMgr::optimize()
 /***************************************************/
 /*   Private member functions about optimization   */
 /***************************************************/
-void 
-CirMgr::clearUnusedFanout( CirGate* g ) {
-  int gFanoutSize = g->fanoutSize(), flag = 0;
-  for ( int i = 0 ; i < gFanoutSize ; ++i ) {
-    if ( !g->_fanoutList[ flag ]->isGlobalRef() ) 
-      g->_fanoutList.erase( g->_fanoutList.begin() + flag );
-    else ++flag;
-  }
-}
-
 void 
 CirMgr::aigOptConstFanin( CirGate* g, int index ) {
   //const 1
   if ( g->invert( index ) ) {
     CirGate* fanin;
-    if ( index == 0 ) fanin = g->_faninList[ 1 ];
-    else              fanin = g->_faninList[ 0 ];
+    if ( index == 0 ) fanin = g->faninGate( 1 );
+    else              fanin = g->faninGate( 0 );
     cout << "Simplifying: " << fanin->getId() << " merging ";
     if ( ( ( index == 0 ) && ( g->invert( 1 ) ) ) || 
          ( ( index == 1 ) && ( g->invert( 0 ) ) ) ) {
@@ -115,13 +183,13 @@ CirMgr::aigOptConstFanin( CirGate* g, int index ) {
 void 
 CirMgr::aigOptSameFanin( CirGate* g ) {
   if ( g->invert( 0 ) == g->invert( 1 ) ) { 
-    cout << "Simplifying: " << g->_faninList[ 0 ]->getId() << " merging ";  
+    cout << "Simplifying: " << g->fanin( 0 ).id() << " merging ";  
     if ( g->invert( 0 ) ) {
       inverseFanoutInvert( g );
       cout << "!";
     }
     cout << g->getId() << "..." << endl;
-    replaceGate( g, g->_faninList[ 0 ] );
+    replaceGate( g, g->faninGate( 0 ) );
   }
   else {
     cout << "Simplifying: 0 merging " << g->getId() << "..." << endl; 
@@ -131,34 +199,33 @@ CirMgr::aigOptSameFanin( CirGate* g ) {
 
 void 
 CirMgr::inverseFanoutInvert( CirGate* g ) {
-  for ( int i = 0, on = g->fanoutSize() ; i < on ; ++i )  
-    for ( int j = 0, in = g->_fanoutList[ i ]->faninSize() ; j < in ; ++j )  
-      if ( g->_fanoutList[ i ]->_faninList[ j ] == g )   
-        g->_fanoutList[ i ]->inverseInvert( j );
+  for ( unsigned e = _fanoutHead[ g->getId() ] ; e != NoEdge ; e = _edgeNext[ e ] ) {
+    CirGateV v = _faninList[ e ]; v.flipInv();
+    setFanin( _totalList[ e / 2 ], e % 2, v );
+  }
 }
 
 void 
 CirMgr::replaceGate( CirGate* tempGate, CirGate* newGate, bool ifec ) {
-  for ( int i = 0, in = tempGate->faninSize() ; i < in ; ++i ) { 
-    int size = tempGate->_faninList[ i ]->fanoutSize(), flag = 0;
-    CirGate* g = tempGate->_faninList[ i];
-    for ( int j = 0 ; j < size ; ++j ) {
-      if ( g->_fanoutList[ flag ] == tempGate ) 
-        g->_fanoutList.erase( g->_fanoutList.begin() + flag );
-      else ++flag;
-    }
+  size_t id = tempGate->getId(), newId = newGate->getId();
+  for ( int i = 0, in = tempGate->faninSize() ; i < in ; ++i ) 
+    removeFanout( 2 * id + i );
+  //rewire the fanouts, then splice their edges onto the list of newGate
+  unsigned head = _fanoutHead[ id ];
+  for ( unsigned e = head ; e != NoEdge ; e = _edgeNext[ e ] ) {
+    bool inv = _faninList[ e ].isInv() ^ ifec;
+    setFanin( _totalList[ e / 2 ], e % 2, CirGateV( newId, inv ) );
   }
-  for ( int i = 0, in = tempGate->fanoutSize() ; i < in ; ++i ) 
-    for ( int j = 0, jn = tempGate->_fanoutList[ i ]->faninSize() ; j < jn ; ++j ) 
-      if ( tempGate->_fanoutList[ i ]->_faninList[ j ] == tempGate ) { 
-        tempGate->_fanoutList[ i ]->_faninList[ j ] = newGate;
-        if ( ifec )
-          tempGate->_fanoutList[ i ]->inverseInvert( j );
-      }
-  for ( int i = 0, on = tempGate->fanoutSize() ; i < on ; ++i )   
-    newGate->_fanoutList.push_back( tempGate->_fanoutList[ i ] );
-  //tempGate->_fanoutList.clear();
-  //tempGate->_faninList.clear();
-  delete _totalList[ tempGate->getId() ];
-  _totalList[ tempGate->getId() ] = NULL;
+  if ( head != NoEdge ) {
+    unsigned tail = _fanoutTail[ newId ];
+    _edgePrev[ head ] = tail;
+    if ( tail == NoEdge ) _fanoutHead[ newId ] = head;
+    else                  _edgeNext[ tail ] = head;
+    _fanoutTail[ newId ] = _fanoutTail[ id ];
+    _fanoutNum[ newId ] += _fanoutNum[ id ];
+  }
+  _fanoutHead[ id ] = _fanoutTail[ id ] = NoEdge; _fanoutNum[ id ] = 0;
+  _faninList[ 2 * id ] = _faninList[ 2 * id + 1 ] = CirGateV();
+  deleteGate( _totalList[ id ] );
+  _totalList[ id ] = NULL;
 }
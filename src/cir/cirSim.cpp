@@ -14,9 +14,15 @@
 #include "cirMgr.h"
 #include "cirGate.h"
 #include "util.h"
+#include "myThread.h"
+#include "myFile.h"
 #include <sstream>
-#include <bitset>
 #include <math.h>
+#include <time.h>
+#if defined( __x86_64__ ) || defined( __i386__ )
+#include <immintrin.h>
+#define CIR_SIM_X86
+#endif
 
 using namespace std;
 
@@ -30,202 +36,1047 @@ using namespace std;
 /**************************************/
 /*   Static varaibles and functions   */
 /**************************************/
-static int MaxFail = 0;
-static int SizeT = sizeof( unsigned long long ) * 8;
+static const size_t SizeT = 64 * SimWords;
 
-static bool
-forSortFecGrp( CirGate* a, CirGate* b ) {
-  return ( a->getId() < b->getId() );
+// One CirSimOp on word blocks:
+//   sim[ out ] = ( sim[ in0 ] ^ m0 ) & ( sim[ in1 ] ^ m1 )
+// m is all ones for an inverted fanin.
+struct SimStep
+{
+  size_t out, in0, in1;
+  unsigned long long m0, m1;
+};
+
+static inline void
+getSimStep( const CirSimOp& op, SimStep& s ) {
+  s.out = SimWords * op.out; 
+  s.in0 = SimWords * op.in0.id(); s.in1 = SimWords * op.in1.id();
+  s.m0 = op.in0.isInv() ? ~0ULL : 0; s.m1 = op.in1.isInv() ? ~0ULL : 0;
+}
+
+// The kernels run the lowered netlist with W = SimWords words per gate,
+// one per instruction set; pickSimKernel() takes the widest one the CPU
+// has, checked with CPUID once at start-up.
+typedef void ( *SimKernel )( unsigned long long*, const CirSimOp*, size_t );
+
+template < size_t W >
+static void
+simScalar( unsigned long long* sim, const CirSimOp* op, size_t n )
+{
+  SimStep s;
+  for ( const CirSimOp* end = op + n ; op != end ; ++op ) {
+    getSimStep( *op, s );
+    for ( size_t w = 0 ; w < W ; ++w )
+      sim[ s.out + w ] = ( sim[ s.in0 + w ] ^ s.m0 ) & ( sim[ s.in1 + w ] ^ s.m1 );
+  }
+}
+
+#ifdef CIR_SIM_X86
+template < size_t W >
+__attribute__(( target( "sse2" ) )) static void
+simSse2( unsigned long long* sim, const CirSimOp* op, size_t n )
+{
+  SimStep s;
+  for ( const CirSimOp* end = op + n ; op != end ; ++op ) {
+    getSimStep( *op, s );
+    __m128i m0 = _mm_set1_epi64x( s.m0 ), m1 = _mm_set1_epi64x( s.m1 );
+    for ( size_t w = 0 ; w < W ; w += 2 ) {
+      __m128i a = _mm_loadu_si128( ( const __m128i* )( sim + s.in0 + w ) );
+      __m128i b = _mm_loadu_si128( ( const __m128i* )( sim + s.in1 + w ) );
+      _mm_storeu_si128( ( __m128i* )( sim + s.out + w ), 
+        _mm_and_si128( _mm_xor_si128( a, m0 ), _mm_xor_si128( b, m1 ) ) );
+    }
+  }
+}
+
+template < size_t W >
+__attribute__(( target( "avx2" ) )) static void
+simAvx2( unsigned long long* sim, const CirSimOp* op, size_t n )
+{
+  SimStep s;
+  for ( const CirSimOp* end = op + n ; op != end ; ++op ) {
+    getSimStep( *op, s );
+    __m256i m0 = _mm256_set1_epi64x( s.m0 ), m1 = _mm256_set1_epi64x( s.m1 );
+    for ( size_t w = 0 ; w < W ; w += 4 ) {
+      __m256i a = _mm256_loadu_si256( ( const __m256i* )( sim + s.in0 + w ) );
+      __m256i b = _mm256_loadu_si256( ( const __m256i* )( sim + s.in1 + w ) );
+      _mm256_storeu_si256( ( __m256i* )( sim + s.out + w ), 
+        _mm256_and_si256( _mm256_xor_si256( a, m0 ), _mm256_xor_si256( b, m1 ) ) );
+    }
+  }
+}
+
+template < size_t W >
+__attribute__(( target( "avx512f" ) )) static void
+simAvx512( unsigned long long* sim, const CirSimOp* op, size_t n )
+{
+  SimStep s;
+  for ( const CirSimOp* end = op + n ; op != end ; ++op ) {
+    getSimStep( *op, s );
+    __m512i m0 = _mm512_set1_epi64( s.m0 ), m1 = _mm512_set1_epi64( s.m1 );
+    for ( size_t w = 0 ; w < W ; w += 8 ) {
+      __m512i a = _mm512_loadu_si512( sim + s.in0 + w );
+      __m512i b = _mm512_loadu_si512( sim + s.in1 + w );
+      _mm512_storeu_si512( sim + s.out + w, 
+        _mm512_and_si512( _mm512_xor_si512( a, m0 ), _mm512_xor_si512( b, m1 ) ) );
+    }
+  }
+}
+#endif
+
+static SimKernel
+pickSimKernel() {
+#ifdef CIR_SIM_X86
+  __builtin_cpu_init();
+  if ( SimWords % 8 == 0 && __builtin_cpu_supports( "avx512f" ) )
+    return simAvx512< SimWords >;
+  if ( SimWords % 4 == 0 && __builtin_cpu_supports( "avx2" ) )
+    return simAvx2< SimWords >;
+  if ( SimWords % 2 == 0 && __builtin_cpu_supports( "sse2" ) )
+    return simSse2< SimWords >;
+#endif
+  return simScalar< SimWords >;
+}
+
+static const SimKernel simKernel = pickSimKernel();
+
+// Event-driven pass over a fanin-closed op list: an op whose fanins kept
+// their words is skipped, the others are recomputed and flag whether
+// their own words changed. The flags of the PIs are set by the caller.
+static void
+simEventKernel( unsigned long long* sim, char* changed, const CirSimOp* op, 
+                size_t n )
+{
+  SimStep s;
+  for ( const CirSimOp* end = op + n ; op != end ; ++op ) {
+    if ( !changed[ op->in0.id() ] && !changed[ op->in1.id() ] ) {
+      changed[ op->out ] = 0; continue;
+    }
+    getSimStep( *op, s );
+    unsigned long long diff = 0;
+    for ( size_t w = 0 ; w < SimWords ; ++w ) {
+      unsigned long long v = 
+        ( sim[ s.in0 + w ] ^ s.m0 ) & ( sim[ s.in1 + w ] ^ s.m1 );
+      diff |= v ^ sim[ s.out + w ]; sim[ s.out + w ] = v;
+    }
+    changed[ op->out ] = diff != 0;
+  }
 }
+
+// Threads take ParallelSimChunk ops of a level at a time, about 64KB of
+// output words. Programs with fewer than ParallelSimNum ops, or whose
+// levels are narrower than a chunk on average, run on one thread.
+static const size_t ParallelSimNum = 1 << 15;
+static const size_t ParallelSimChunk = 8192 / SimWords;
+
+// Ops of a level only read lower levels, so the threads claim chunks of a
+// level from a shared counter and wait until all of it is done before
+// going on: a short spin, then on levelDone, which the thread finishing
+// the level signals. Waiting on the done count instead of a barrier still
+// works when myParallelRun() has to run a share late on the calling thread.
+struct SimLevelJob
+{
+  SimLevelJob( size_t levelNum ) : next( levelNum, 0 ), done( levelNum, 0 ) {
+    pthread_mutex_init( &lock, 0 ); pthread_cond_init( &levelDone, 0 ); }
+  ~SimLevelJob() { 
+    pthread_mutex_destroy( &lock ); pthread_cond_destroy( &levelDone ); }
+
+  unsigned long long*   sim;
+  const CirSimOp*       op;
+  const unsigned*       levelBegin;
+  vector< size_t >      next;
+  vector< size_t >      done;
+  pthread_mutex_t       lock;
+  pthread_cond_t        levelDone;
+};
+
+static const int SimSpin = 1 << 10;
+
+// a larger thread count must be this much faster to be kept
+static const double TuneGain = 1.1;
+static const int TuneRuns = 2;
+
+static double
+wallTime() {
+  timespec t;
+  clock_gettime( CLOCK_MONOTONIC, &t );
+  return t.tv_sec + t.tv_nsec * 1e-9;
+}
+
+// Bit c of a[ r ] becomes bit r of a[ c ].
+static void
+transpose64( unsigned long long* a ) {
+  unsigned long long m = 0x00000000FFFFFFFFULL;
+  for ( int j = 32 ; j ; j >>= 1, m ^= m << j )
+    for ( int k = 0 ; k < 64 ; k = ( ( k | j ) + 1 ) & ~j ) {
+      unsigned long long t = ( ( a[ k ] >> j ) ^ a[ k | j ] ) & m;
+      a[ k ] ^= t << j; a[ k | j ] ^= t;
+    }
+}
+
+// A whole signature as a hash key. A signature and its inverse are the
+// same key, both taken as the one whose bit 0 is 0.
+class SimKey
+{
+public:
+  SimKey() {}
+  SimKey( const unsigned long long* s ): 
+    _sim( s ), _mask( ( s[ 0 ] & 1 ) ? ~0ULL : 0 ) {}
+  size_t operator() () const { 
+    unsigned long long h = 0;
+    for ( size_t w = 0 ; w < SimWords ; ++w ) 
+      h = h * 10007 + ( _sim[ w ] ^ _mask );
+    return h;
+  }
+  bool operator == ( const SimKey& k ) const {
+    for ( size_t w = 0 ; w < SimWords ; ++w )
+      if ( ( _sim[ w ] ^ _mask ) != ( k._sim[ w ] ^ k._mask ) ) return false;
+    return true;
+  }
+private:
+  const unsigned long long*   _sim;
+  unsigned long long          _mask;
+};
+
+// Open-addressed table from signatures to FEC labels, reused for every
+// group of every round. Entries carry the number of the group they were
+// put in, so starting a group clears nothing.
+class SimTable
+{
+public:
+  SimTable() : _epoch( 0 ), _mask( 0 ), _shift( 63 ) {}
+  void start( size_t n ) {
+    size_t cap = 2; int bits = 1;
+    while ( cap < 2 * n ) { cap <<= 1; ++bits; }
+    if ( cap > _entry.size() ) { _entry.assign( cap, Entry() ); _epoch = 0; }
+    _mask = cap - 1; _shift = 64 - bits;
+    if ( ++_epoch == 0 ) { 
+      _entry.assign( _entry.size(), Entry() ); _epoch = 1; 
+    }
+  }
+  // label of the first gate put in with the value of gate id in sim, or
+  // its inverse; l, put in for id, if none
+  unsigned find( const unsigned long long* sim, unsigned id, unsigned l ) {
+    SimKey k( sim + SimWords * id );
+    for ( size_t i = ( k() * 0x9E3779B97F4A7C15ULL ) >> _shift ; ; 
+          i = ( i + 1 ) & _mask ) {
+      Entry& e = _entry[ i ];
+      if ( e.epoch != _epoch ) { 
+        e.epoch = _epoch; e.id = id; e.label = l; 
+        return l; 
+      }
+      if ( SimKey( sim + SimWords * e.id ) == k ) return e.label;
+    }
+  }
+private:
+  struct Entry 
+  { 
+    Entry() : epoch( 0 ) {} 
+    unsigned epoch, id, label; 
+  };
+  vector< Entry >             _entry;
+  unsigned                    _epoch;
+  size_t                      _mask;
+  int                         _shift;
+};
+
+// File patterns read ahead: the PI words of block t of the batch are
+// words[ t ][ SimWords * k + w ] for PI k, the patterns themselves are
+// kept only for the log. err is the message for a bad pattern.
+struct SimPatternBatch
+{
+  vector< vector< unsigned long long > >    words;
+  vector< string >                          text;
+  size_t                                    num;
+  string                                    err;
+};
+
+// The reader of CirMgr::fileSim(), filling batch[ 0 ] and batch[ 1 ] in
+// turn with up to blockNum blocks of patterns. rows are the patterns of
+// the current 64 as bit rows, 64 PIs a word, waiting to be transposed.
+struct SimPatternJob
+{
+  SimPatternJob( istream& f, size_t n, bool text ) : 
+    file( f ), blockNum( n ), keepText( text ), lineNo( 0 ) {}
+
+  istream&                                  file;
+  size_t                                    blockNum;
+  bool                                      keepText;
+  size_t                                    lineNo;
+  string                                    token;
+  vector< unsigned long long >              rows;
+  SimPatternBatch                           batch[ 2 ];
+};
+
+// Packed pattern and response files: a header of four 64-bit words, the
+// magic, the numbers of PIs, POs and patterns, then ( patterns + 63 ) / 64
+// words for every PI (pattern file) or PO (response file) in order, with
+// pattern p as bit p % 64 of word p / 64 and unused bits 0. All words are
+// in the byte order of the host; on x86 the magics read "CIRPAT01" and
+// "CIRRSP01".
+static const unsigned long long PackedPatternMagic = 0x3130544150524943ULL;
+static const unsigned long long PackedResponseMagic = 0x3130505352524943ULL;
+static const size_t PackedHeaderSize = 4;
+
+// A mapped packed pattern file and the PO words of its response, 0
+// without a log
+struct SimPackedFile
+{
+  const unsigned long long*                 words;     // of PI 0
+  size_t                                    wordNum;   // per PI
+  size_t                                    num;       // patterns
+  unsigned long long*                       response;  // of PO 0
+};
+
+// Pattern-parallel simulation: thread t simulates block t of a batch into
+// its own buffer sim[ t ] and labels every FEC member by its class under
+// that block in label[ t ]. The labels are then applied block by block,
+// so the groups come out as if the blocks had been simulated one after
+// another. sim[ 0 ] is _simList, the others are taken from buf. With a
+// cone program, changed[ t ] holds the events of buffer t once it has had
+// a full cone pass and is empty before.
+struct SimBlockJob
+{
+  SimBlockJob( size_t n ) : sim( n ), label( n ), table( n ), buf( n ), 
+    changed( n ), log( n ), patterns( 0 ), packed( 0 ), program( 0 ), 
+    random( false ), round( 0 ), blockNum( 0 ), candNum( 0 ), fail( 0 ), 
+    start( 0 ) {}
+
+  vector< unsigned long long* >             sim;
+  vector< IdList >                          label;
+  vector< SimTable >                        table;
+  vector< vector< unsigned long long > >    buf;
+  vector< vector< char > >                  changed;
+  vector< string >                          log;  // lines of each block
+  const SimPatternBatch*                    patterns;  // file patterns
+  const SimPackedFile*                      packed;    // or packed ones
+  const vector< CirSimOp >*                 program;  // 0 for _simProgram
+  bool                                      random;
+  // random stream, or block of the packed file, of block 0
+  size_t                                    round;
+  size_t                                    blockNum;
+  // random simulation: candidates left, blocks in a row without enough
+  // gain and the wall time it started
+  size_t                                    candNum;
+  size_t                                    fail;
+  double                                    start;
+};
+
+// Random simulation stops after SimPatience blocks in a row that each
+// eliminate at most a _simGain share of the candidates, the members that
+// are not the first of their group.
+static const size_t SimPatience = 8;
+
+// Extra block buffers take at most ParallelSimBytes together.
+static const size_t ParallelSimBytes = 1 << 28;
+
 /************************************************/
 /*   Public member functions about Simulation   */
 /************************************************/
+// Every block draws from its own stream of _simSeed, so each one gets new
+// patterns, the same whatever the number of threads. The blocks go on
+// until stopRandomSim() says so.
 void
 CirMgr::randomSim()
 {
   initFecGrp();
-  int patternNum = 0;
-  determineMaxFail();
-  for ( int count = 0 ; count < MaxFail ; ++count, patternNum += 64 ) {
-    createRandomSim();
-    simulate();
-    identifyFEC();
+  size_t patternNum = 0, blockNum = 0, grpNum = fecGrpNum();
+  SimBlockJob job( simBlockNum() );
+  job.random = true;
+  job.candNum = _fecMemberList.size() - grpNum;
+  job.start = wallTime();
+  size_t candNum = job.candNum;
+  bool stop = false;
+  while ( !stop ) {
+    job.blockNum = job.sim.size();
+    job.round = _simRound;
+    prepareSimBlocks( job );
+    stop = simulateBlocks( job );
+    _simRound += job.blockNum; blockNum += job.blockNum;
+    patternNum += job.blockNum * SizeT;
   }
+  _simWord = SimWords - 1;
   cout << patternNum << " patterns simulated." << endl;
+  cout << blockNum << " blocks: FEC groups " << grpNum << " -> " 
+       << fecGrpNum() << ", candidates " << candNum << " -> " 
+       << job.candNum << "; stopped by ";
+  if ( job.candNum == 0 ) cout << "no candidates left" << endl;
+  else if ( job.fail >= SimPatience ) 
+    cout << "gain <= " << _simGain << " in " << SimPatience << " blocks" 
+         << endl;
+  else cout << "time limit " << _simTimeLimit << "s" << endl;
   sortFecGrp();
   assignFecGrp();
 }
 
+// Checks the magic and leaves the file at its start.
+bool
+CirMgr::isPackedPatternFile( ifstream& patternFile ) const
+{
+  unsigned long long magic = 0;
+  patternFile.read( ( char* )&magic, sizeof( magic ) );
+  bool packed = patternFile && magic == PackedPatternMagic;
+  patternFile.clear(); patternFile.seekg( 0 );
+  return packed;
+}
+
+// The file is read one batch ahead on its own thread while the current
+// batch is simulated, so memory stays at two batches. A bad pattern ends
+// the run and puts the FEC groups back as they were.
 void
-CirMgr::fileSim(ifstream& patternFile)
+CirMgr::fileSim(ifstream& patternFile, const string& fileName)
 {
+  if ( isPackedPatternFile( patternFile ) ) {
+    packedFileSim( fileName );
+    return;
+  }
   initFecGrp();
-  vector< unsigned long long > simValue; bool err = false; 
-  string temp; vector< string > input;
-  //while ( getline( patternFile, temp, '\n' ) )
-  while ( patternFile >> temp )
-    input.push_back( temp );
-  if ( !checkErr( input ) ) err = true;
-  if ( !err ) {
-    for ( size_t done = 0, inputSize = input.size(); done<inputSize; done+=SizeT)    {
-      stringToSim( input, done );
-      simulate(); 
-      identifyFEC();
-      if ( _simLog ) outputFile( input, done );
+  IdList members( _fecMemberList ), begins( _fecBeginList );
+  SimBlockJob job( simBlockNum() );
+  SimPatternJob read( patternFile, job.sim.size(), _simLog != 0 );
+  readPatterns( read, 0 );
+  size_t patternNum = 0;
+  for ( size_t k = 0 ; ; k ^= 1 ) {
+    const SimPatternBatch& batch = read.batch[ k ];
+    if ( !batch.err.empty() ) {
+      cout << batch.err << endl;
+      _fecMemberList.swap( members ); _fecBeginList.swap( begins );
+      assignFecGrp();
+      return;
     }
-    cout << input.size() << " patterns simulated." << endl;
-    sortFecGrp();
-    assignFecGrp();
+    if ( batch.num == 0 ) break;
+    bool ahead = batch.num == job.sim.size() * SizeT;
+    MyThreadJob< CirMgr, SimPatternJob > 
+      next( this, &CirMgr::readPatterns, &read, k ^ 1 );
+    pthread_t tid;
+    bool async = ahead && pthread_create( &tid, 0, next.entry, &next ) == 0;
+    job.blockNum = ( batch.num + SizeT - 1 ) / SizeT;
+    job.patterns = &batch;
+    prepareSimBlocks( job );
+    simulateBlocks( job );
+    _simWord = ( batch.num - 1 ) % SizeT / 64;
+    patternNum += batch.num;
+    if ( async ) pthread_join( tid, 0 );
+    else if ( ahead ) next.run();
+    else read.batch[ k ^ 1 ].num = 0;
   }
+  cout << patternNum << " patterns simulated." << endl;
+  sortFecGrp();
+  assignFecGrp();
 }
 
 /*************************************************/
 /*   Private member functions about Simulation   */
 /*************************************************/
-void 
-CirMgr::determineMaxFail() {
-  MaxFail = 10;
-  if ( _netList.size() < 100 ) 
-    MaxFail = _netList.size();
-  else 
-    MaxFail = sqrt( _netList.size() ) / 5;
+// A packed pattern file is mapped and simulated in place; its response
+// file, if logged, gets the same layout for the POs. The response is
+// gathered in memory and written at once after the last block.
+void
+CirMgr::packedFileSim( const string& fileName ) {
+  MyMappedFile file;
+  if ( !file.open( fileName ) || file.size() < 8 * PackedHeaderSize ) {
+    cout << "Error: Packed pattern file(" << fileName 
+         << ") cannot be read!!" << endl;
+    return;
+  }
+  const unsigned long long* header = 
+    ( const unsigned long long* )file.begin();
+  if ( header[ 1 ] != _piList.size() ) {
+    cout << "Error: Packed patterns of " << header[ 1 ] 
+         << " inputs do not match the number of inputs(" << _piList.size()
+         << ") in a circuit!!" << endl;
+    return;
+  }
+  if ( header[ 2 ] != _poList.size() ) {
+    cout << "Error: Packed patterns of " << header[ 2 ] 
+         << " outputs do not match the number of outputs(" << _poList.size()
+         << ") in a circuit!!" << endl;
+    return;
+  }
+  // bound the count by the words the file holds before sizing from it
+  size_t avail = file.size() / 8 - PackedHeaderSize;
+  if ( !_piList.empty() ) avail /= _piList.size();
+  if ( header[ 3 ] > 64 * ( unsigned long long )avail ) {
+    cout << "Error: Packed pattern file(" << fileName 
+         << ") is truncated!!" << endl;
+    return;
+  }
+  SimPackedFile f;
+  f.num = header[ 3 ]; f.wordNum = ( f.num + 63 ) / 64;
+  f.words = header + PackedHeaderSize;
+  vector< unsigned long long > 
+    response( _simLog ? f.wordNum * _poList.size() : 0 );
+  f.response = response.empty() ? 0 : &response[ 0 ];
+  initFecGrp();
+  SimBlockJob job( simBlockNum() );
+  job.packed = &f;
+  size_t blockNum = ( f.wordNum + SimWords - 1 ) / SimWords;
+  for ( size_t b = 0 ; b < blockNum ; b += job.blockNum ) {
+    job.blockNum = blockNum - b;
+    if ( job.blockNum > job.sim.size() ) job.blockNum = job.sim.size();
+    job.round = b;
+    prepareSimBlocks( job );
+    simulateBlocks( job );
+  }
+  if ( f.wordNum ) _simWord = ( f.wordNum - 1 ) % SimWords;
+  if ( _simLog ) {
+    unsigned long long h[ PackedHeaderSize ] = 
+      { PackedResponseMagic, _piList.size(), _poList.size(), f.num };
+    _simLog->write( ( const char* )h, sizeof( h ) );
+    if ( f.response ) 
+      _simLog->write( ( const char* )f.response, 8 * response.size() );
+  }
+  cout << f.num << " patterns simulated." << endl;
+  sortFecGrp();
+  assignFecGrp();
+}
+
+// Called after each block of random simulation is applied.
+bool
+CirMgr::stopRandomSim( SimBlockJob& job ) const {
+  size_t candNum = _fecMemberList.size() - fecGrpNum();
+  if ( job.candNum - candNum <= _simGain * job.candNum ) ++job.fail;
+  else job.fail = 0;
+  job.candNum = candNum;
+  return candNum == 0 || job.fail >= SimPatience || 
+         ( _simTimeLimit > 0 && wallTime() - job.start >= _simTimeLimit );
 }
 
 void 
-CirMgr::createRandomSim() {
-  RandomNumGen g( 0 );
+CirMgr::createRandomSim( size_t stream, unsigned long long* block ) const {
+  RandomWordGen g( _simSeed, stream );
   for ( size_t i = 0, in = _piList.size() ; i < in ; ++i ) {
-    unsigned long long temp = g( INT_MAX );
-    temp = temp << 32;
-    temp += g( INT_MAX );
-    _piList[ i ]->setSim( temp );
+    unsigned long long* sim = block + SimWords * _piList[ i ]->getId();
+    for ( size_t w = 0 ; w < SimWords ; ++w ) sim[ w ] = g();
   }
 }
 
+// Without -Threads, the first parallel pass of a circuit warms up with
+// TuneRuns serial passes, then takes the best of TuneRuns passes on 1, 2,
+// 4, ... threads up to the core count, and the fastest count is kept.
+// Each trial is a whole pass, so the signatures do not depend on it.
 void 
 CirMgr::simulate() {
-  //CirGate::setGlobalRef();
-  //for ( size_t i = 0, on = _poList.size() ; i < on ; ++i )
-  //  _poList[ i ]->simulate();
-  for ( size_t i = 0, in = _netList.size() ; i < in ; ++i ) 
-    _netList[ i ]->simulate();
+  if ( _simProgram.empty() ) lowerNetList();
+  size_t n = _simThreads ? _simThreads : 
+             _simTuned ? _simTuned : myNumThreads();
+  if ( n > MY_MAX_THREADS ) n = MY_MAX_THREADS;
+  size_t levelNum = _simLevelBegin.size() - 1;
+  if ( n < 2 || _simProgram.size() < ParallelSimNum || 
+       _simProgram.size() < levelNum * ParallelSimChunk ) n = 1;
+  else if ( !_simThreads && !_simTuned ) { tuneSimThreads( n ); return; }
+  simulate( n );
+}
+
+void
+CirMgr::simulate( size_t n ) {
+  _simStale = false;
+  if ( n < 2 ) {
+    simKernel( &_simList[ 0 ], _simProgram.empty() ? 0 : &_simProgram[ 0 ], 
+               _simProgram.size() );
+    return;
+  }
+  SimLevelJob job( _simLevelBegin.size() - 1 );
+  job.sim = &_simList[ 0 ]; job.op = &_simProgram[ 0 ];
+  job.levelBegin = &_simLevelBegin[ 0 ];
+  myParallelRun( this, &CirMgr::simulateLevels, job, n );
+}
+
+void
+CirMgr::tuneSimThreads( size_t maxN ) {
+  for ( int r = 0 ; r < TuneRuns ; ++r ) simulate( 1 );
+  double best = 0;
+  _simTuned = 1;
+  for ( size_t n = 1 ; ; n = ( 2 * n < maxN ) ? 2 * n : maxN ) {
+    double t = 0;
+    for ( int r = 0 ; r < TuneRuns ; ++r ) {
+      double t0 = wallTime();
+      simulate( n );
+      t0 = wallTime() - t0;
+      if ( r == 0 || t0 < t ) t = t0;
+    }
+    if ( n == 1 || t * TuneGain < best ) { best = t; _simTuned = n; }
+    else break;
+    if ( n == maxN ) break;
+  }
+}
+
+void
+CirMgr::simulateLevels( SimLevelJob& job, size_t ) {
+  for ( size_t l = 0, ln = job.next.size() ; l < ln ; ++l ) {
+    size_t size = job.levelBegin[ l + 1 ] - job.levelBegin[ l ];
+    const CirSimOp* op = job.op + job.levelBegin[ l ];
+    for ( ;; ) {
+      size_t i = __sync_fetch_and_add( &job.next[ l ], ParallelSimChunk );
+      if ( i >= size ) break;
+      size_t k = size - i < ParallelSimChunk ? size - i : ParallelSimChunk;
+      simKernel( job.sim, op + i, k );
+      if ( __sync_add_and_fetch( &job.done[ l ], k ) == size ) {
+        pthread_mutex_lock( &job.lock );
+        pthread_cond_broadcast( &job.levelDone );
+        pthread_mutex_unlock( &job.lock );
+      }
+    }
+    for ( int s = 0 ; s < SimSpin ; ++s )
+      if ( __sync_fetch_and_add( &job.done[ l ], 0 ) == size ) break;
+    pthread_mutex_lock( &job.lock );
+    while ( __sync_fetch_and_add( &job.done[ l ], 0 ) < size )
+      pthread_cond_wait( &job.levelDone, &job.lock );
+    pthread_mutex_unlock( &job.lock );
+  }
+}
+
+// One thread per block, bounded by ParallelSimBytes for the extra buffers.
+size_t
+CirMgr::simBlockNum() const {
+  size_t n = _simThreads ? _simThreads : myNumThreads();
+  if ( n > MY_MAX_THREADS ) n = MY_MAX_THREADS;
+  size_t bytes = _simList.size() * sizeof( unsigned long long );
+  if ( bytes && n > 1 + ParallelSimBytes / bytes ) 
+    n = 1 + ParallelSimBytes / bytes;
+  return n;
+}
+
+void
+CirMgr::prepareSimBlocks( SimBlockJob& job ) {
+  job.sim[ 0 ] = &_simList[ 0 ];
+  for ( size_t t = 1 ; t < job.blockNum ; ++t ) {
+    if ( job.buf[ t ].empty() ) job.buf[ t ].assign( _simList.size(), 0 );
+    job.sim[ t ] = &job.buf[ t ][ 0 ];
+  }
+}
+
+// Simulates the job.blockNum blocks of a batch and refines the groups by
+// them in order. A single block runs through simulate(), which may still
+// split the levels among threads. _simList keeps the values of the last 
+// block, as if simulated alone. Random simulation may stop within the
+// batch; job.blockNum is then cut to the blocks applied and true returned.
+bool
+CirMgr::simulateBlocks( SimBlockJob& job ) {
+  if ( job.blockNum == 1 && !job.program ) {
+    loadSimBlock( job, 0 );
+    simulate(); 
+    labelFec( job.sim[ 0 ], job.label[ 0 ], job.table[ 0 ] );
+    refineFec( job.label[ 0 ] );
+    if ( job.patterns && _simLog ) 
+      formatLog( job.patterns->text, 0, job.sim[ 0 ], job.log[ 0 ] );
+    writeLog( job, 0 );
+    return job.random && stopRandomSim( job );
+  }
+  if ( _simProgram.empty() ) lowerNetList();
+  if ( job.blockNum == 1 ) simulateBlock( job, 0 );
+  else myParallelRun( this, &CirMgr::simulateBlock, job, job.blockNum );
+  bool stop = false;
+  for ( size_t t = 0 ; t < job.blockNum && !stop ; ++t ) {
+    refineFec( job.label[ t ] );
+    writeLog( job, t );
+    if ( job.random && stopRandomSim( job ) ) {
+      job.blockNum = t + 1; stop = true;
+    }
+  }
+  if ( job.blockNum > 1 && job.program ) 
+    copyConeSim( job.buf[ job.blockNum - 1 ], *job.program );
+  else if ( job.blockNum > 1 ) _simList.swap( job.buf[ job.blockNum - 1 ] );
+  return stop;
+}
+
+// Only the PIs and the cone gates of "sim" were simulated, so only they
+// are copied into _simList.
+void
+CirMgr::copyConeSim( const vector< unsigned long long >& sim, 
+                     const vector< CirSimOp >& cone ) {
+  for ( size_t i = 0, in = _piList.size() ; i < in ; ++i ) {
+    size_t k = SimWords * _piList[ i ]->getId();
+    copy( &sim[ k ], &sim[ k ] + SimWords, &_simList[ k ] );
+  }
+  for ( size_t i = 0, in = cone.size() ; i < in ; ++i ) {
+    size_t k = SimWords * cone[ i ].out;
+    copy( &sim[ k ], &sim[ k ] + SimWords, &_simList[ k ] );
+  }
+}
+
+// PI values of block t from the pattern file or the random streams; other
+// sources fill them before the run.
+void
+CirMgr::loadSimBlock( SimBlockJob& job, size_t t ) const {
+  if ( job.patterns ) {
+    const unsigned long long* words = &job.patterns->words[ t ][ 0 ];
+    for ( size_t k = 0, kn = _piList.size() ; k < kn ; ++k ) {
+      unsigned long long* sim = job.sim[ t ] + SimWords * _piList[ k ]->getId();
+      for ( size_t w = 0 ; w < SimWords ; ++w ) 
+        sim[ w ] = words[ SimWords * k + w ];
+    }
+  }
+  else if ( job.packed ) {
+    const SimPackedFile& f = *job.packed;
+    size_t word = ( job.round + t ) * SimWords;
+    for ( size_t k = 0, kn = _piList.size() ; k < kn ; ++k ) {
+      const unsigned long long* words = f.words + f.wordNum * k;
+      unsigned long long* sim = job.sim[ t ] + SimWords * _piList[ k ]->getId();
+      for ( size_t w = 0 ; w < SimWords ; ++w )
+        sim[ w ] = word + w < f.wordNum ? words[ word + w ] : 0;
+      if ( word + SimWords >= f.wordNum && f.num % 64 )
+        sim[ f.wordNum - 1 - word ] &= ( 1ULL << f.num % 64 ) - 1;
+    }
+  }
+  else if ( job.random ) createRandomSim( job.round + t, job.sim[ t ] );
+}
+
+// Writes the log of block t, in order after the blocks before it: the
+// lines formatLog() made, or for a packed file the PO words of the block
+// at their places in the response.
+void
+CirMgr::writeLog( SimBlockJob& job, size_t t ) {
+  if ( !_simLog ) return;
+  if ( job.patterns ) 
+    _simLog->write( job.log[ t ].data(), job.log[ t ].size() );
+  else if ( job.packed ) {
+    const SimPackedFile& f = *job.packed;
+    size_t word = ( job.round + t ) * SimWords, n = f.wordNum - word;
+    if ( n > SimWords ) n = SimWords;
+    for ( size_t j = 0, jn = _poList.size() ; j < jn ; ++j ) {
+      const unsigned long long* sim = 
+        job.sim[ t ] + SimWords * _poList[ j ]->getId();
+      unsigned long long* po = f.response + f.wordNum * j + word;
+      copy( sim, sim + n, po );
+      if ( word + n == f.wordNum && f.num % 64 ) 
+        po[ n - 1 ] &= ( 1ULL << f.num % 64 ) - 1;
+    }
+  }
+}
+
+// Simulates pattern words[ 0 ~ wordNum - 1 ], words[ j ][ k ] holding 64
+// patterns of PI k, SimWords words a block; the rest of the last block is 0.
+// Only the fanin cones of the FEC members are simulated once they are at
+// most half of the netlist; the other gates then keep older values and
+// _simStale is set until simulate() runs again. A buffer reused for a
+// later block only recomputes the cone gates whose fanins changed.
+void
+CirMgr::simulateWords( const vector< vector< unsigned long long > >& words, 
+                       size_t wordNum ) {
+  SimBlockJob job( simBlockNum() );
+  vector< CirSimOp > cone;
+  if ( _simProgram.empty() ) lowerNetList();
+  lowerFecCones( cone );
+  if ( 2 * cone.size() <= _simProgram.size() ) job.program = &cone;
+  if ( job.program ) _simStale = true;
+  size_t blockNum = ( wordNum + SimWords - 1 ) / SimWords;
+  for ( size_t b = 0 ; b < blockNum ; b += job.blockNum ) {
+    job.blockNum = blockNum - b;
+    if ( job.blockNum > job.sim.size() ) job.blockNum = job.sim.size();
+    prepareSimBlocks( job );
+    for ( size_t t = 0 ; t < job.blockNum ; ++t ) {
+      size_t j = ( b + t ) * SimWords;
+      vector< char >& changed = job.changed[ t ];
+      for ( size_t k = 0, kn = _piList.size() ; k < kn ; ++k ) {
+        unsigned id = _piList[ k ]->getId();
+        unsigned long long* sim = job.sim[ t ] + SimWords * id, diff = 0;
+        for ( size_t w = 0 ; w < SimWords ; ++w ) {
+          unsigned long long v = j + w < wordNum ? words[ j + w ][ k ] : 0;
+          diff |= v ^ sim[ w ]; sim[ w ] = v;
+        }
+        if ( !changed.empty() ) changed[ id ] = diff != 0;
+      }
+    }
+    simulateBlocks( job );
+  }
+  _simWord = ( wordNum - 1 ) % SimWords;
+}
+
+void
+CirMgr::simulateBlock( SimBlockJob& job, size_t t ) {
+  loadSimBlock( job, t );
+  const vector< CirSimOp >& p = job.program ? *job.program : _simProgram;
+  if ( job.program && !job.changed[ t ].empty() && !p.empty() )
+    simEventKernel( job.sim[ t ], &job.changed[ t ][ 0 ], &p[ 0 ], p.size() );
+  else {
+    simKernel( job.sim[ t ], p.empty() ? 0 : &p[ 0 ], p.size() );
+    if ( job.program ) job.changed[ t ].assign( _totalList.size(), 0 );
+  }
+  labelFec( job.sim[ t ], job.label[ t ], job.table[ t ] );
+  if ( job.patterns && _simLog ) 
+    formatLog( job.patterns->text, t * SizeT, job.sim[ t ], job.log[ t ] );
+}
+
+// An AIG is in0 & in1 and a PO, whose two fanins are the same, is in0, so
+// both lower to one CirSimOp. Gates without fanins and the NULL slots
+// fraig merges leave in _netList get none. The ops are then counting
+// sorted by level, keeping the _netList order within a level.
+void 
+CirMgr::lowerNetList() {
+  vector< CirSimOp > ops;
+  IdList level( _totalList.size(), 0 ), opLevel;
+  for ( size_t i = 0, n = _netList.size() ; i < n ; ++i ) {
+    if ( !_netList[ i ] ) continue;
+    unsigned id = _netList[ i ]->getId();
+    CirSimOp op = { id, _faninList[ 2 * id ], _faninList[ 2 * id + 1 ] };
+    if ( op.in0.isNull() ) continue;
+    unsigned l0 = level[ op.in0.id() ], l1 = level[ op.in1.id() ];
+    level[ id ] = ( l0 > l1 ? l0 : l1 ) + 1;
+    ops.push_back( op );
+    opLevel.push_back( level[ id ] - 1 );
+  }
+  _simLevelBegin.assign( 1, 0 );
+  for ( size_t i = 0, n = ops.size() ; i < n ; ++i ) {
+    if ( opLevel[ i ] + 2 > _simLevelBegin.size() ) 
+      _simLevelBegin.resize( opLevel[ i ] + 2, 0 );
+    ++_simLevelBegin[ opLevel[ i ] + 1 ];
+  }
+  for ( size_t l = 1, ln = _simLevelBegin.size() ; l < ln ; ++l )
+    _simLevelBegin[ l ] += _simLevelBegin[ l - 1 ];
+  _simProgram.resize( ops.size() );
+  IdList pos( _simLevelBegin.begin(), _simLevelBegin.end() - 1 );
+  for ( size_t i = 0, n = ops.size() ; i < n ; ++i )
+    _simProgram[ pos[ opLevel[ i ] ]++ ] = ops[ i ];
+}
+
+// The fanin cones of the FEC members lowered in DFS post-order, which
+// keeps every op after the ops of its fanins. A gate is marked when it is
+// expanded, so one pushed twice is expanded once, from its last push.
+void
+CirMgr::lowerFecCones( vector< CirSimOp >& ops ) {
+  ops.clear();
+  _coneMark.start( _totalList.size() );
+  IdList stack;
+  for ( size_t j = 0, jn = _fecMemberList.size() ; j < jn ; ++j ) {
+    stack.push_back( 2 * _fecMemberList[ j ] );
+    while ( !stack.empty() ) {
+      unsigned e = stack.back(), id = e / 2;
+      if ( e & 1 ) {
+        stack.pop_back();
+        CirSimOp op = { id, _faninList[ 2 * id ], _faninList[ 2 * id + 1 ] };
+        if ( !op.in0.isNull() ) ops.push_back( op );
+        continue;
+      }
+      if ( _coneMark.isMarked( id ) ) { stack.pop_back(); continue; }
+      _coneMark.mark( id ); stack.back() |= 1;
+      for ( int i = 0 ; i < 2 ; ++i ) {
+        CirGateV fi = _faninList[ 2 * id + i ];
+        if ( !fi.isNull() && !_coneMark.isMarked( fi.id() ) ) 
+          stack.push_back( 2 * fi.id() );
+      }
+    }
+  }
 }
 
 void
 CirMgr::initFecGrp() 
 {
-  if ( _fecGrpList.size() == 0 ) {
-    vector< CirGate* > fecGrp;
-    fecGrp.push_back( _totalList[ 0 ] );
+  if ( fecGrpNum() == 0 ) {
+    _fecMemberList.assign( 1, 0 );
     for ( int i = 0, n = _netList.size() ; i < n ; ++i )
       if ( _netList[ i ]->gateType() == AIG_GATE ) 
-        fecGrp.push_back( _netList[ i ] );
-    _fecGrpList.push_back( fecGrp );
+        _fecMemberList.push_back( _netList[ i ]->getId() );
+    _fecBeginList.assign( 1, 0 );
+    _fecBeginList.push_back( _fecMemberList.size() );
   }
 }
 
+// Labels every member by the first position in its group of a member with
+// the same value in sim, so equal labels within a group are equal values.
 void
-CirMgr::identifyFEC() 
+CirMgr::labelFec( const unsigned long long* sim, IdList& label, 
+                  SimTable& table ) const
 {
-  size_t temp = _fecGrpList.size();
-  for ( size_t i = 0, in = _fecGrpList.size() ; i < in ; ++i ) {
-    HashMap< HashKey, CirGate* > newFecGrps( getHashSize( _fecGrpList[ i ].size() ) );
-    for ( size_t j = 0, jn = _fecGrpList[ i ].size() ; j < jn ; ++j ) {
-      HashKey k( _fecGrpList[ i ][ j ]->getSim() );
-      CirGate* grp;
-      if ( newFecGrps.check( k, grp ) )    
-        _fecGrpList[ grp->_grpNo ].push_back( _fecGrpList[ i ][ j ] );
-      else {
-        _fecGrpList[ i ][ j ]->_grpNo = _fecGrpList.size();
-        vector< CirGate* > temp;
-        temp.push_back( _fecGrpList[ i ][ j ] );
-        _fecGrpList.push_back( temp );
-        newFecGrps.forceInsert( k, _fecGrpList[ i ][ j ] );
+  if ( label.size() < _totalList.size() ) label.resize( _totalList.size() );
+  for ( size_t i = 0, in = fecGrpNum() ; i < in ; ++i ) {
+    size_t b = _fecBeginList[ i ], e = _fecBeginList[ i + 1 ];
+    table.start( e - b );
+    for ( size_t j = b ; j < e ; ++j ) {
+      unsigned id = _fecMemberList[ j ];
+      label[ id ] = table.find( sim, id, j - b );
+    }
+  }
+}
+
+// Splits every group by label, in place in _fecMemberList. The new groups
+// keep the order they are first seen in and singletons are dropped. The
+// labels may come from an earlier, coarser pool, as they are only
+// compared within a group. The work lists are members kept between
+// rounds, so nothing is allocated once they have grown.
+void
+CirMgr::refineFec( const IdList& label ) 
+{
+  IdList &slot = _fecSlot, &grpOf = _fecGrpOf, &grpPos = _fecGrpPos;
+  IdList &temp = _fecTemp, &begins = _fecNewBegin;
+  begins.assign( 1, 0 );
+  size_t out = 0;
+  for ( size_t i = 0, in = fecGrpNum() ; i < in ; ++i ) {
+    size_t b = _fecBeginList[ i ], e = _fecBeginList[ i + 1 ];
+    if ( grpOf.size() < e - b ) { 
+      grpOf.resize( e - b ); temp.resize( e - b ); 
+    }
+    grpPos.clear();
+    for ( size_t j = b ; j < e ; ++j ) {
+      unsigned l = label[ _fecMemberList[ j ] ];
+      if ( l >= slot.size() ) slot.resize( l + 1, CirGateV::NullLId );
+      unsigned& grp = slot[ l ];
+      if ( grp == CirGateV::NullLId ) { 
+        grp = grpPos.size(); 
+        grpPos.push_back( 0 ); 
       }
+      ++grpPos[ grp ];
+      grpOf[ j - b ] = grp;
+    }
+    for ( size_t j = b ; j < e ; ++j ) 
+      slot[ label[ _fecMemberList[ j ] ] ] = CirGateV::NullLId;
+    // sizes to start positions in temp, CirGateV::NullLId for singletons
+    unsigned size = 0;
+    for ( size_t g = 0, gn = grpPos.size() ; g < gn ; ++g ) {
+      if ( grpPos[ g ] == 1 ) { grpPos[ g ] = CirGateV::NullLId; continue; }
+      unsigned pos = size;
+      size += grpPos[ g ];
+      begins.push_back( out + size );
+      grpPos[ g ] = pos;
+    }
+    for ( size_t j = b ; j < e ; ++j ) {
+      unsigned& pos = grpPos[ grpOf[ j - b ] ];
+      if ( pos != CirGateV::NullLId ) temp[ pos++ ] = _fecMemberList[ j ];
     }
+    // out <= b, so the groups moved never overwrite members still unread
+    for ( size_t j = 0 ; j < size ; ++j ) 
+      _fecMemberList[ out + j ] = temp[ j ];
+    out += size;
   }
-  vector< vector< CirGate* > > tempGrpList;
-  for ( size_t i = temp, in = _fecGrpList.size() ; i < in ; ++i )
-    if ( _fecGrpList[ i ].size() > 1 )  
-      tempGrpList.push_back( _fecGrpList[ i ] );
-  _fecGrpList.clear();
-  _fecGrpList = tempGrpList;
-  //return !( _fecGrpList.size() == temp );
+  _fecMemberList.resize( out );
+  _fecBeginList.swap( begins );
 }
 
+// Formats the log lines of patterns text[ done ~ done + SizeT - 1 ] into
+// out: the pattern, a space and the PO bits. The PO words of every 64
+// patterns are transposed into a row of 64 POs a word for each pattern.
 void
-CirMgr::outputFile( vector< string >& input, size_t& done ) {
-  unsigned long long pos = 1;
-  unsigned long long in = ( ( input.size() - done ) > SizeT ) ? ( done + 64 ) : input.size();  
-  for ( size_t i = done ; i < in ; ++i ) {
-    *_simLog << input[ i ] << " ";
-    for ( size_t j = 0, jn = _poList.size() ; j < jn ; ++j ) {
-      if ( _poList[ j ]->getSim() & pos ) *_simLog << "1";
-      else                                *_simLog << "0";
+CirMgr::formatLog( const vector< string >& text, size_t done, 
+                   const unsigned long long* sim, string& out ) const {
+  size_t in = text.size() - done > SizeT ? done + SizeT : text.size();
+  size_t poNum = _poList.size(), grpNum = ( poNum + 63 ) / 64, size = 0;
+  for ( size_t i = done ; i < in ; ++i ) size += text[ i ].size() + poNum + 2;
+  out.resize( size );
+  char* c = size ? &out[ 0 ] : 0;
+  vector< unsigned long long > rows( 64 * grpNum );
+  for ( size_t i = done ; i < in ; i += 64 ) {
+    size_t w = ( i - done ) / 64;
+    for ( size_t g = 0 ; g < grpNum ; ++g ) {
+      for ( size_t k = 0 ; k < 64 ; ++k ) 
+        rows[ 64 * g + k ] = 64 * g + k < poNum ? 
+          sim[ SimWords * _poList[ 64 * g + k ]->getId() + w ] : 0;
+      transpose64( &rows[ 64 * g ] );
+    }
+    for ( size_t r = 0 ; r < 64 && i + r < in ; ++r ) {
+      const string& p = text[ i + r ];
+      c = copy( p.begin(), p.end(), c );
+      *c++ = ' ';
+      for ( size_t j = 0 ; j < poNum ; ++j ) 
+        *c++ = '0' + ( ( rows[ 64 * ( j / 64 ) + r ] >> ( j % 64 ) ) & 1 );
+      *c++ = '\n';
     }
-    *_simLog << endl;
-    pos = pos << 1;
   }
 }
 
+// Reads up to a full batch of patterns into read.batch[ k ]. Each is
+// checked and packed as a row of 64 PIs a word; every 64 rows are then
+// transposed into the PI words of those 64 patterns.
+void
+CirMgr::readPatterns( SimPatternJob& read, size_t k ) {
+  SimPatternBatch& batch = read.batch[ k ];
+  size_t piNum = _piList.size(), grpNum = ( piNum + 63 ) / 64;
+  size_t maxNum = read.blockNum * SizeT;
+  batch.num = 0; batch.text.clear(); batch.err.clear();
+  batch.words.resize( read.blockNum );
+  for ( size_t t = 0 ; t < read.blockNum ; ++t ) 
+    batch.words[ t ].assign( SimWords * piNum, 0 );
+  read.rows.assign( 64 * grpNum, 0 );
+  string& p = read.token;
+  while ( batch.num < maxNum && read.file >> p ) {
+    ++read.lineNo;
+    if ( !packPattern( p, read, batch ) ) break;
+    if ( read.keepText ) batch.text.push_back( p );
+    if ( ++batch.num % 64 == 0 ) flushPatterns( read, batch );
+  }
+  if ( batch.num % 64 ) flushPatterns( read, batch );
+}
+
+// Sets bit c of rows[ 64 * g + r ], r the row of p, to PI 64 * g + c of p.
 bool
-CirMgr::checkErr( vector< string > input ) {
-  for ( int i = 0, n = input.size(), in = _piList.size() ; i < n ; ++i )
-    if ( input[ i ].size() != in ) {
-      cout << "line " << i + 1 << " : ";
-      cout << "Error: Pattern(" << input[ i ] 
-           << ") length(" << input[ i ].size() 
-           << ") does not match the number of inputs(" << in
-           << ") in a circuit!!" << endl;
+CirMgr::packPattern( const string& p, SimPatternJob& read, 
+                     SimPatternBatch& batch ) const {
+  size_t piNum = _piList.size();
+  if ( p.size() != piNum ) {
+    ostringstream err;
+    err << "line " << read.lineNo << " : Error: Pattern(" << p 
+        << ") length(" << p.size() 
+        << ") does not match the number of inputs(" << piNum
+        << ") in a circuit!!";
+    batch.err = err.str();
+    return false;
+  }
+  unsigned long long* row = &read.rows[ batch.num % 64 ];
+  const char* c = p.data();
+  size_t i = 0;
+#ifdef __SSE2__
+  // '0' and '1' differ from 0x30 in bit 0 only, which << 7 moves to the
+  // sign bit of its byte
+  const __m128i zero = _mm_set1_epi8( 0x30 ), mask = _mm_set1_epi8( ~1 );
+  for ( ; i + 16 <= piNum ; i += 16 ) {
+    __m128i v = _mm_loadu_si128( ( const __m128i* )( c + i ) );
+    if ( _mm_movemask_epi8( _mm_cmpeq_epi8( _mm_and_si128( v, mask ), zero ) )
+         != 0xFFFF ) break;
+    unsigned long long bits = _mm_movemask_epi8( _mm_slli_epi64( v, 7 ) );
+    row[ 64 * ( i / 64 ) ] |= bits << ( i % 64 );
+  }
+#endif
+  for ( ; i < piNum ; ++i ) {
+    if ( c[ i ] != '0' && c[ i ] != '1' ) {
+      ostringstream err;
+      err << "Error: Pattern(" << p 
+          << ") contains a non-0/1 character(\'" << c[ i ] << ").";
+      batch.err = err.str();
       return false;
     }
-  for ( int  i = 0, in = input.size() ; i < in ; ++i )
-    for ( int j = 0, jn = input[ i ].size() ; j < jn ; ++j )
-      if ( input[ i ][ j ] != '0' && input[ i ][ j ] != '1' ) { 
-        cout << "Error: Pattern(" << input[ i ] 
-             << ") contains a non-0/1 character(\'"
-             << input[ i ][ j ] << ")." << endl;
-        return false;
-      }
+    if ( c[ i ] == '1' ) row[ 64 * ( i / 64 ) ] |= 1ULL << ( i % 64 );
+  }
   return true;
 }
 
-//done should not be changed
+// Moves the rows of the last, possibly partial, 64 patterns read into
+// their PI words and clears them.
 void
-CirMgr::stringToSim( vector< string >& input, size_t& done ) {
-  size_t jn = ( ( input.size() - done ) > SizeT ) ?( done+SizeT ):input.size(); 
-  string s; stringstream ss;
-  for ( size_t i = 0, in = _piList.size() ; i < in ; ++i ) {
-    s = "";
-    for ( size_t j = ( jn - 1 ) ; j >= done ; --j ) {
-      s += input[ j ][ i ];
-      if ( ( j == 0 ) && ( done == 0 ) ) break;
+CirMgr::flushPatterns( SimPatternJob& read, SimPatternBatch& batch ) const {
+  size_t piNum = _piList.size(), last = ( batch.num - 1 ) % SizeT;
+  unsigned long long* words = &batch.words[ ( batch.num - 1 ) / SizeT ][ 0 ];
+  for ( size_t g = 0, gn = read.rows.size() / 64 ; g < gn ; ++g ) {
+    unsigned long long* rows = &read.rows[ 64 * g ];
+    transpose64( rows );
+    for ( size_t c = 0 ; c < 64 ; ++c ) {
+      if ( 64 * g + c < piNum ) 
+        words[ SimWords * ( 64 * g + c ) + last / 64 ] = rows[ c ];
+      rows[ c ] = 0;
     }
-    bitset< sizeof( unsigned long long ) * 8 > sn( s );
-    unsigned long long temp = sn.to_ulong();
-    stringstream ss;
-    ss << hex << temp;
-    _piList[ i ]->setSim( temp );
-    ss.str( "" ); ss.clear();
   }
 }
 
 void 
 CirMgr::sortFecGrp() {
-  for ( size_t i = 0, in = _fecGrpList.size() ; i < in ; ++i )  
-    sort( _fecGrpList[ i ].begin(), _fecGrpList[ i ].end(), forSortFecGrp ); 
+  for ( size_t i = 0, in = fecGrpNum() ; i < in ; ++i )  
+    sort( _fecMemberList.begin() + _fecBeginList[ i ], 
+          _fecMemberList.begin() + _fecBeginList[ i + 1 ] ); 
 }
 
 void 
 CirMgr::assignFecGrp() {
-  CirGate::setGlobalRef();
-  for ( size_t i = 0, in = _fecGrpList.size() ; i < in ; ++i )   
-    for ( size_t j = 0, jn = _fecGrpList[ i ].size() ; j < jn ; ++j ) {
-      _fecGrpList[ i ][ j ]->setToGlobalRef();
-      _fecGrpList[ i ][ j ]->_fecGrp = _fecGrpList[ i ];
-    }
-  for ( size_t i = 0, in = _totalList.size() ; i < in ; ++i )
-    if ( _totalList[ i ] )
-      if ( !_totalList[ i ]->isGlobalRef() )  
-        _totalList[ i ]->_fecGrp.clear();
+  _fecList.assign( _totalList.size(), CirGateV() );
+  for ( size_t i = 0, in = fecGrpNum() ; i < in ; ++i ) {
+    unsigned long long lead = getSim( _fecMemberList[ _fecBeginList[ i ] ] );
+    for ( size_t j = _fecBeginList[ i ], jn = _fecBeginList[ i + 1 ] ; 
+          j < jn ; ++j ) {
+      unsigned id = _fecMemberList[ j ];
+      _fecList[ id ] = CirGateV( i, getSim( id ) != lead );
+    }
+  }
+}
+
+void 
+CirMgr::popFecGrp() {
+  _fecBeginList.pop_back();
+  _fecMemberList.resize( _fecBeginList.back() );
 }
@@ -0,0 +1,311 @@
+/****************************************************************************
+  FileName     [ cirSnap.cpp ]
+  PackageName  [ cir ]
+  Synopsis     [ Define cir snapshot( save / load ) functions ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+#include "cirMgr.h"
+#include "cirGate.h"
+#include "myFile.h"
+#include "util.h"
+
+using namespace std;
+
+// TODO: Keep "CirMgr::saveSnapshot()" and "CirMgr::loadSnapshot()" for
+//       cir cmds.
+
+/*******************************/
+/*   Global variable and enum  */
+/*******************************/
+// A snapshot is the header followed by flat arrays, so a mapped file can be
+// read in place:
+//   unsigned long long  sim[ gateNum * simWords ]
+//   unsigned            id, type, lineNo, fanin0, fanin1[ gateNum ]
+//   unsigned            fanoutBegin[ gateNum + 1 ], fanout[ fanoutNum ]
+//   unsigned            pi[ piNum ], po[ poNum ], net[ netNum ]
+//   unsigned            fecBegin[ fecGrpNum + 1 ], fec[ fecMemberNum ]
+//   char                symbol[ symbolSize ]
+// Fanins are literals( 2 * id + invert ), CirGateV::NullLId if absent.
+// Fanouts and FEC groups are indices into their arrays, which keep the
+// list order.
+// Bump SnapVersion whenever this layout changes.
+struct CirSnapHeader
+{
+   char       magic[ 8 ];
+   unsigned   version;
+   unsigned   endian;
+   unsigned   cmdState;
+   unsigned   maxVariables;
+   unsigned   totalSize;
+   unsigned   gateNum;
+   unsigned   piNum;
+   unsigned   poNum;
+   unsigned   netNum;
+   unsigned   fanoutNum;
+   unsigned   fecGrpNum;
+   unsigned   fecMemberNum;
+   unsigned   symbolSize;
+   unsigned   simWords;
+   unsigned   simWord;
+};
+
+/**************************************/
+/*   Static varaibles and functions   */
+/**************************************/
+static const char     SnapMagic[ 8 ] = { 'C','I','R','S','N','A','P','\0' };
+static const unsigned SnapVersion = 2;
+static const unsigned SnapEndian = 0x01020304;
+
+template < typename T >
+static void
+writeArray( ofstream& ofs, const vector< T >& v ) {
+  if ( v.size() )
+    ofs.write( reinterpret_cast< const char* >( &v[ 0 ] ), sizeof( T ) * v.size() );
+}
+
+// hand out the next n elements of the mapped file, 0 if it is too short
+template < typename T >
+static const T*
+nextArray( const char*& p, const char* end, size_t n ) {
+  if ( n > size_t( end - p ) / sizeof( T ) ) return 0;
+  const T* a = reinterpret_cast< const T* >( p );
+  p += sizeof( T ) * n;
+  return a;
+}
+
+static bool
+snapError( const string& fileName ) {
+  cerr << "Error: \"" << fileName << "\" is not a valid snapshot!!" << endl;
+  return false;
+}
+
+/*************************************************/
+/*   Public member functions about snapshot      */
+/*************************************************/
+bool
+CirMgr::saveSnapshot( const string& fileName, unsigned cmdState ) const
+{
+  ofstream ofs( fileName.c_str(), ios::out | ios::binary );
+  if ( !ofs ) {
+    cerr << "Cannot open snapshot \"" << fileName << "\"!!" << endl;
+    return false;
+  }
+  vector< unsigned long long > sim;
+  vector< unsigned > id, type, line, fanin0, fanin1, fanoutBegin, fanout;
+  vector< unsigned > index( _totalList.size(), 0 );
+  for ( size_t i = 0, in = _totalList.size() ; i < in ; ++i ) {
+    if ( !_totalList[ i ] ) continue;
+    index[ i ] = id.size();
+    id.push_back( i );
+  }
+  for ( size_t i = 0, in = id.size() ; i < in ; ++i ) {
+    CirGate* g = _totalList[ id[ i ] ];
+    sim.insert( sim.end(), _simList.begin() + SimWords * id[ i ],
+                _simList.begin() + SimWords * ( id[ i ] + 1 ) );
+    type.push_back( g->gateType() );
+    line.push_back( g->getLineNo() );
+    CirGateV f[ 2 ];
+    for ( int j = 0, jn = g->faninSize() ; j < jn ; ++j )
+      f[ j ] = g->fanin( j );
+    fanin0.push_back( f[ 0 ].lId() ); fanin1.push_back( f[ 1 ].lId() );
+    fanoutBegin.push_back( fanout.size() );
+    for ( unsigned e = _fanoutHead[ id[ i ] ] ; e != NoEdge ; e = _edgeNext[ e ] )
+      fanout.push_back( index[ e / 2 ] );
+  }
+  fanoutBegin.push_back( fanout.size() );
+  vector< unsigned > pi, po, net, fecBegin, fec;
+  for ( size_t i = 0, in = _piList.size() ; i < in ; ++i )
+    pi.push_back( index[ _piList[ i ]->getId() ] );
+  for ( size_t i = 0, in = _poList.size() ; i < in ; ++i )
+    po.push_back( index[ _poList[ i ]->getId() ] );
+  for ( size_t i = 0, in = _netList.size() ; i < in ; ++i )
+    net.push_back( index[ _netList[ i ]->getId() ] );
+  fecBegin.push_back( 0 );
+  for ( size_t i = 0, in = fecGrpNum() ; i < in ; ++i ) {
+    for ( size_t j = _fecBeginList[ i ] ; j < _fecBeginList[ i + 1 ] ; ++j )
+      fec.push_back( index[ _fecMemberList[ j ] ] );
+    fecBegin.push_back( fec.size() );
+  }
+  string symbol;
+  for ( size_t i = 0, in = _symbolInput.size() ; i < in ; ++i )
+    symbol += _symbolInput[ i ] + '\n';
+
+  CirSnapHeader h;
+  memset( &h, 0, sizeof( h ) );
+  memcpy( h.magic, SnapMagic, sizeof( h.magic ) );
+  h.version = SnapVersion;       h.endian = SnapEndian;
+  h.cmdState = cmdState;         h.maxVariables = _maxVariables;
+  h.totalSize = _totalList.size();
+  h.gateNum = id.size();         h.piNum = pi.size();
+  h.poNum = po.size();           h.netNum = net.size();
+  h.fanoutNum = fanout.size();   h.fecGrpNum = fecGrpNum();
+  h.fecMemberNum = fec.size();   h.symbolSize = symbol.size();
+  h.simWords = SimWords;         h.simWord = _simWord;
+  ofs.write( reinterpret_cast< const char* >( &h ), sizeof( h ) );
+  writeArray( ofs, sim );
+  writeArray( ofs, id );     writeArray( ofs, type );
+  writeArray( ofs, line );   writeArray( ofs, fanin0 );
+  writeArray( ofs, fanin1 ); writeArray( ofs, fanoutBegin );
+  writeArray( ofs, fanout );
+  writeArray( ofs, pi );     writeArray( ofs, po );
+  writeArray( ofs, net );
+  writeArray( ofs, fecBegin ); writeArray( ofs, fec );
+  ofs.write( symbol.data(), symbol.size() );
+  if ( !ofs ) {
+    cerr << "Error: cannot write snapshot \"" << fileName << "\"!!" << endl;
+    return false;
+  }
+  return true;
+}
+
+// Rebuild every gate from the mapped arrays. Nothing is parsed or
+// simulated again; FEC groups of the gates come from assignFecGrp().
+bool
+CirMgr::loadSnapshot( const string& fileName, unsigned& cmdState )
+{
+  MyMappedFile file;
+  if ( !file.open( fileName ) ) {
+    cerr << "Cannot open snapshot \"" << fileName << "\"!!" << endl;
+    return false;
+  }
+  const char* p = file.begin(), *end = file.end();
+  const CirSnapHeader* h = nextArray< CirSnapHeader >( p, end, 1 );
+  if ( !h || memcmp( h->magic, SnapMagic, sizeof( SnapMagic ) ) ||
+       h->endian != SnapEndian )
+    return snapError( fileName );
+  if ( h->version != SnapVersion ) {
+    cerr << "Error: snapshot version " << h->version
+         << " is not supported( expect " << SnapVersion << " )!!" << endl;
+    return false;
+  }
+  if ( h->simWords != SimWords ) {
+    cerr << "Error: snapshot has " << h->simWords << " simulation words per "
+         << "gate( expect " << SimWords << " )!!" << endl;
+    return false;
+  }
+  size_t n = h->gateNum;
+  if ( h->simWord >= SimWords || n > size_t( end - p ) / SimWords ) 
+    return snapError( fileName );
+  const unsigned long long* sim = 
+    nextArray< unsigned long long >( p, end, n * SimWords );
+  const unsigned* id = nextArray< unsigned >( p, end, n );
+  const unsigned* type = nextArray< unsigned >( p, end, n );
+  const unsigned* line = nextArray< unsigned >( p, end, n );
+  const unsigned* fanin0 = nextArray< unsigned >( p, end, n );
+  const unsigned* fanin1 = nextArray< unsigned >( p, end, n );
+  const unsigned* fanoutBegin = nextArray< unsigned >( p, end, n + 1 );
+  const unsigned* fanout = nextArray< unsigned >( p, end, h->fanoutNum );
+  const unsigned* pi = nextArray< unsigned >( p, end, h->piNum );
+  const unsigned* po = nextArray< unsigned >( p, end, h->poNum );
+  const unsigned* net = nextArray< unsigned >( p, end, h->netNum );
+  const unsigned* fecBegin = 
+    nextArray< unsigned >( p, end, size_t( h->fecGrpNum ) + 1 );
+  const unsigned* fec = nextArray< unsigned >( p, end, h->fecMemberNum );
+  const char* symbol = nextArray< char >( p, end, h->symbolSize );
+  if ( !sim || !id || !type || !line || !fanin0 || !fanin1 || !fanoutBegin ||
+       !fanout || !pi || !po || !net || !fecBegin || !fec || !symbol ||
+       p != end || fanoutBegin[ n ] != h->fanoutNum ||
+       fecBegin[ h->fecGrpNum ] != h->fecMemberNum )
+    return snapError( fileName );
+  for ( size_t i = 0 ; i < n ; ++i )
+    if ( id[ i ] >= h->totalSize || type[ i ] >= TOT_GATE ||
+         fanoutBegin[ i ] > fanoutBegin[ i + 1 ] ||
+         ( type[ i ] == AIG_GATE && ( fanin0[ i ] == CirGateV::NullLId ||
+                                      fanin1[ i ] == CirGateV::NullLId ) ) ||
+         ( type[ i ] == PO_GATE && fanin0[ i ] == CirGateV::NullLId ) )
+      return snapError( fileName );
+  for ( size_t i = 0 ; i < h->fecGrpNum ; ++i )
+    if ( fecBegin[ i ] > fecBegin[ i + 1 ] ) return snapError( fileName );
+  if ( fecBegin[ 0 ] != 0 ) return snapError( fileName );
+
+  _maxVariables = h->maxVariables;
+  _totalList.assign( h->totalSize, NULL );
+  vector< CirGate* > gate( n );
+  for ( size_t i = 0 ; i < n ; ++i ) {
+    if ( _totalList[ id[ i ] ] ) { clear(); return snapError( fileName ); }
+    CirGate* g;
+    switch( type[ i ] ) {
+      case PI_GATE:    g = createGate< CirPiGate >( id[ i ], line[ i ] );
+                       break;
+      case PO_GATE:    g = createGate< CirPoGate >( id[ i ], line[ i ] );
+                       break;
+      case CONST_GATE: g = createGate< CirConstGate >( id[ i ], line[ i ] );
+                       break;
+      case AIG_GATE:   g = createGate< CirAigGate >( id[ i ], line[ i ] );
+                       _aigList.push_back( g );
+                       break;
+      default:         g = createGate< CirUndefGate >( id[ i ], line[ i ] );
+                       break;
+    }
+    gate[ i ] = _totalList[ id[ i ] ] = g;
+  }
+  initStore();
+  for ( size_t i = 0 ; i < n ; ++i ) {
+    CirGateV f[ 2 ] = { fanin0[ i ], fanin1[ i ] };
+    for ( int j = 0, jn = gate[ i ]->faninSize() ; j < jn ; ++j ) {
+      if ( f[ j ].id() >= h->totalSize || !_totalList[ f[ j ].id() ] )
+        { clear(); return snapError( fileName ); }
+      setFanin( gate[ i ], j, f[ j ] );
+    }
+  }
+  // each stored fanout takes the first fanin slot of that gate which points
+  // back here and is not linked yet, so the list order is kept
+  vector< bool > linked( _edgeNext.size(), false );
+  for ( size_t i = 0 ; i < n ; ++i ) {
+    for ( unsigned j = fanoutBegin[ i ] ; j < fanoutBegin[ i + 1 ] ; ++j ) {
+      if ( fanout[ j ] >= n ) { clear(); return snapError( fileName ); }
+      unsigned e = 2 * id[ fanout[ j ] ];
+      if ( linked[ e ] || _faninList[ e ].id() != id[ i ] ) ++e;
+      if ( e % 2 >= (unsigned)gate[ fanout[ j ] ]->faninSize() ||
+           linked[ e ] || _faninList[ e ].id() != id[ i ] )
+        { clear(); return snapError( fileName ); }
+      linked[ e ] = true;
+      addFanout( e );
+    }
+  }
+  // every list holds gates of its own kind, and the net list is in
+  // topological order: a defined fanin of an AIG or a PO comes before it
+  for ( size_t i = 0 ; i < h->piNum ; ++i )
+    if ( pi[ i ] >= n || type[ pi[ i ] ] != PI_GATE )
+      { clear(); return snapError( fileName ); }
+  for ( size_t i = 0 ; i < h->poNum ; ++i )
+    if ( po[ i ] >= n || type[ po[ i ] ] != PO_GATE )
+      { clear(); return snapError( fileName ); }
+  vector< unsigned > netPos( h->totalSize, ~0u );
+  for ( size_t i = 0 ; i < h->netNum ; ++i ) {
+    if ( net[ i ] >= n || type[ net[ i ] ] == UNDEF_GATE || 
+         netPos[ id[ net[ i ] ] ] != ~0u )
+      { clear(); return snapError( fileName ); }
+    const CirGateV* f = &_faninList[ 2 * id[ net[ i ] ] ];
+    for ( int j = 0 ; j < 2 ; ++j )
+      if ( !f[ j ].isNull() && netPos[ f[ j ].id() ] == ~0u &&
+           _totalList[ f[ j ].id() ]->gateType() != UNDEF_GATE )
+        { clear(); return snapError( fileName ); }
+    netPos[ id[ net[ i ] ] ] = i;
+  }
+  for ( unsigned i = 0 ; i < h->piNum ; ++i ) _piList.push_back( gate[ pi[ i ] ] );
+  for ( unsigned i = 0 ; i < h->poNum ; ++i ) _poList.push_back( gate[ po[ i ] ] );
+  for ( unsigned i = 0 ; i < h->netNum ; ++i ) _netList.push_back( gate[ net[ i ] ] );
+  rankNetList();
+  for ( size_t i = 0 ; i < n ; ++i ) 
+    copy( sim + SimWords * i, sim + SimWords * ( i + 1 ), 
+          _simList.begin() + SimWords * id[ i ] );
+  _simWord = h->simWord;
+  _fecBeginList.assign( fecBegin, fecBegin + h->fecGrpNum + 1 );
+  for ( unsigned i = 0 ; i < h->fecMemberNum ; ++i ) {
+    if ( fec[ i ] >= n ) { clear(); return snapError( fileName ); }
+    _fecMemberList.push_back( id[ fec[ i ] ] );
+  }
+  assignFecGrp();
+  computeLevel();
+  const char* s = symbol;
+  parseSymbol( s, symbol + h->symbolSize );
+  cmdState = h->cmdState;
+  return true;
+}
@@ -0,0 +1,18 @@
+#!/bin/sh
+# benchDfs.sh [fraig ...] : time six CIRRead runs of a 1M-level AND chain
+# with each fraig. The stack is unlimited so a recursive DFS survives and
+# old and new builds can be compared.
+[ $# -gt 0 ] || set -- ../../../bin/fraig
+[ -f chain1m.aag ] || ./cirGen chain 1000000 > chain1m.aag
+printf "cirr chain1m.aag\n" > benchDfs.do
+for i in 1 2 3 4 5; do printf "cirr -r chain1m.aag\n" >> benchDfs.do; done
+printf "q -f\n" >> benchDfs.do
+
+now() { date +%s.%N; }
+for fraig in "$@"; do
+  t0=`now`
+  ( ulimit -s unlimited; $fraig -f benchDfs.do > /dev/null 2>&1 ) || \
+    echo "FAIL: $fraig"
+  t1=`now`
+  echo "$fraig: `echo "$t0 $t1" | awk '{ printf "%.2f", $2 - $1 }'`s"
+done
@@ -0,0 +1,16 @@
+#!/bin/sh
+# benchFanout.sh [fraig ...] : time CIRSTRash of "cirGen fanout 100000"
+# with each fraig. One gate collects 100k fanouts and then loses them
+# one merge at a time; the result must be 2 AIGs.
+[ $# -gt 0 ] || set -- ../../../bin/fraig
+[ -f fo100k.aag ] || ./cirGen fanout 100000 > fo100k.aag
+printf "cirr fo100k.aag\ncirstr\ncirp\nq -f\n" > benchFanout.do
+
+now() { date +%s.%N; }
+for fraig in "$@"; do
+  t0=`now`
+  aig=`$fraig -f benchFanout.do 2>&1 | grep "^  AIG" | awk '{ print $2 }'`
+  t1=`now`
+  [ "$aig" = 2 ] || echo "FAIL: $fraig leaves $aig AIGs"
+  echo "$fraig: `echo "$t0 $t1" | awk '{ printf "%.2f", $2 - $1 }'`s"
+done
@@ -0,0 +1,32 @@
+#!/bin/sh
+# benchThreads.sh [fraig] [maxThreads] [ands] : time CIRSIMulate -Random
+# on "cirGen wide" with 1, 2, 4, ... maxThreads threads( default 32 ), and
+# with the count simulate() measures itself( "auto" ). FEC groups must be
+# the same for every count. Run it on the target machine and build with
+# -DMY_MAX_THREADS=n if the scaling stops below n.
+fraig=${1:-../../../bin/fraig}
+max=${2:-32}
+ands=${3:-200000}
+[ -f wide$ands.aag ] || ./cirGen wide $ands > wide$ands.aag
+
+now() { date +%s.%N; }
+run() {
+  printf "cirr wide$ands.aag\ncirsim -r -t $1\ncirp -fec\nq -f\n" > benchThreads.do
+  t0=`now`
+  $fraig -f benchThreads.do 2>&1 | grep "^\[" | cksum > threads.out
+  t1=`now`
+  echo "$t0 $t1" | awk '{ printf "%.2f", $2 - $1 }'
+}
+
+base=`run 1`; cp threads.out threads1.out
+echo "threads 1: ${base}s"
+n=2
+while [ $n -le $max ]; do
+  t=`run $n`
+  cmp -s threads.out threads1.out || echo "FAIL: FEC groups differ at $n"
+  echo "threads $n: ${t}s, speedup `echo "$base $t" | awk '{ printf "%.2f", $1 / $2 }'`"
+  n=`expr $n \* 2`
+done
+t=`run 0`
+cmp -s threads.out threads1.out || echo "FAIL: FEC groups differ at auto"
+echo "threads auto: ${t}s, speedup `echo "$base $t" | awk '{ printf "%.2f", $1 / $2 }'`"
@@ -0,0 +1,187 @@
+/****************************************************************************
+  FileName     [ cirGen.cpp ]
+  PackageName  [ cir/test ]
+  Synopsis     [ Generate AIGER circuits for the cir benchmarks ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2012-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+
+using namespace std;
+
+// chain n: n ANDs, each of the one before( inverted every other level )
+// and PI b, so the circuit is n levels deep
+static void
+genChain( size_t n )
+{
+  size_t m = n + 2;
+  cout << "aag " << m << " 2 0 1 " << n << "\n2\n4\n" 
+       << 2 * m + 1 << "\n";
+  cout << "6 2 4\n";
+  for ( size_t v = 4 ; v <= m ; ++v )
+    cout << 2 * v << " " << 2 * ( v - 1 ) + ( v % 2 == 0 ) << " 4\n";
+}
+
+// fanout n: n copies of a & b, each fanning out to its own AND with c.
+// Strash merges the copies into one gate that collects n fanouts, then
+// merges the second-level ANDs, each leaving that long fanout list.
+static void
+genFanout( size_t n )
+{
+  size_t m = 2 * n + 3;
+  cout << "aag " << m << " 3 0 " << n << " " << 2 * n << "\n2\n4\n6\n";
+  for ( size_t v = n + 4 ; v <= m ; ++v ) cout << 2 * v << "\n";
+  for ( size_t v = 4 ; v < n + 4 ; ++v ) cout << 2 * v << " 2 4\n";
+  for ( size_t v = n + 4 ; v <= m ; ++v ) 
+    cout << 2 * v << " " << 2 * ( v - n ) << " 6\n";
+}
+
+// 48-bit linear congruential generator, the same sequence everywhere
+static unsigned long long seed = 1;
+
+static size_t
+rnd( size_t n ) {
+  seed = ( seed * 0x5DEECE66DULL + 11 ) & ( ( 1ULL << 48 ) - 1 );
+  return ( seed >> 17 ) % n;
+}
+
+// random n: n ANDs over 16 PIs, 8 POs. Fanins come mostly from the last
+// 40 gates, some are constant and some copy an earlier AND's fanins, so
+// there are FEC groups to find.
+static void
+genRandom( size_t n )
+{
+  size_t in = 16, on = 8;
+  vector< size_t > lit, fanin;
+  for ( size_t i = 1 ; i <= in ; ++i ) lit.push_back( 2 * i );
+  for ( size_t k = 0 ; k < n ; ++k ) {
+    size_t f[ 2 ];
+    for ( int j = 0 ; j < 2 ; ++j ) {
+      size_t b = lit.size() < 40 ? 0 : lit.size() - 40;
+      f[ j ] = ( rnd( 4 ) ? lit[ b + rnd( lit.size() - b ) ]
+                          : lit[ rnd( lit.size() ) ] ) ^ rnd( 2 );
+    }
+    if ( rnd( 20 ) == 0 ) f[ 0 ] = rnd( 2 );
+    if ( rnd( 20 ) == 0 && k ) {
+      size_t c = rnd( k );
+      f[ 0 ] = fanin[ 2 * c + 1 ]; f[ 1 ] = fanin[ 2 * c ];
+    }
+    fanin.push_back( f[ 0 ] ); fanin.push_back( f[ 1 ] );
+    lit.push_back( 2 * ( in + 1 + k ) );
+  }
+  cout << "aag " << in + n << " " << in << " 0 " << on << " " << n << "\n";
+  for ( size_t i = 1 ; i <= in ; ++i ) cout << 2 * i << "\n";
+  for ( size_t o = 0 ; o < on ; ++o ) 
+    cout << lit[ lit.size() - 1 - rnd( 60 ) ] + rnd( 2 ) << "\n";
+  for ( size_t k = 0 ; k < n ; ++k )
+    cout << 2 * ( in + 1 + k ) << " " << fanin[ 2 * k ] << " " 
+         << fanin[ 2 * k + 1 ] << "\n";
+}
+
+// wide n: 20 levels of n / 20 ANDs over as many PIs. AND j of a level
+// takes gate j and a random gate of the level below, so every gate is
+// used, and the top level drives the POs.
+static void
+genWide( size_t n )
+{
+  size_t w = n / 20 ? n / 20 : 1, m = 21 * w;
+  cout << "aag " << m << " " << w << " 0 " << w << " " << 20 * w << "\n";
+  for ( size_t i = 1 ; i <= w ; ++i ) cout << 2 * i << "\n";
+  for ( size_t i = 1 ; i <= w ; ++i ) cout << 2 * ( 20 * w + i ) << "\n";
+  for ( size_t d = 1 ; d <= 20 ; ++d )
+    for ( size_t j = 1 ; j <= w ; ++j )
+      cout << 2 * ( d * w + j ) << " " << 2 * ( ( d - 1 ) * w + j ) + rnd( 2 )
+           << " " << 2 * ( ( d - 1 ) * w + 1 + rnd( w ) ) + rnd( 2 ) << "\n";
+}
+
+// adds the AND of literals a and b as gate ++m and returns its literal
+static size_t
+addAnd( vector< size_t >& fanin, size_t& m, size_t a, size_t b )
+{
+  fanin.push_back( a ); fanin.push_back( b );
+  return 2 * ++m;
+}
+
+static size_t
+addXor( vector< size_t >& fanin, size_t& m, size_t a, size_t b )
+{
+  size_t t0 = addAnd( fanin, m, a, b ^ 1 ), t1 = addAnd( fanin, m, a ^ 1, b );
+  return addAnd( fanin, m, t0 ^ 1, t1 ^ 1 ) ^ 1;
+}
+
+// minterm n: over 24 PIs, n ANDs d of two random 12-PI minterms and n
+// ANDs !s & !d with s = PI 1 & PI 2. Random simulation leaves the d in
+// the FEC group of constant 0 and the others in the group of s, while SAT
+// tells them apart, so fraig collects hundreds of patterns at once. The
+// XORs of every three PIs, which random simulation splits, are the rest
+// of the circuit. Each !s & !d and each XOR of three drives a PO.
+static void
+genMinterm( size_t n )
+{
+  size_t in = 24, hn = 40, m = in;
+  vector< size_t > half, fanin, po;
+  for ( size_t h = 0 ; h < 2 * hn ; ++h ) {
+    size_t b = h < hn ? 1 : 13, lit = 2 * b + rnd( 2 );
+    for ( size_t i = b + 1 ; i < b + 12 ; ++i ) 
+      lit = addAnd( fanin, m, lit, 2 * i + rnd( 2 ) );
+    half.push_back( lit );
+  }
+  size_t s = addAnd( fanin, m, 2, 4 );
+  for ( size_t k = 0 ; k < n ; ++k ) {
+    size_t d = addAnd( fanin, m, half[ k % hn ], 
+                       half[ hn + ( k / hn + k ) % hn ] );
+    po.push_back( addAnd( fanin, m, s ^ 1, d ^ 1 ) );
+  }
+  for ( size_t i = 1 ; i <= in ; ++i )
+    for ( size_t j = i + 1 ; j <= in ; ++j ) {
+      size_t x = addXor( fanin, m, 2 * i, 2 * j );
+      for ( size_t k = j + 1 ; k <= in ; ++k ) 
+        po.push_back( addXor( fanin, m, x, 2 * k ) );
+    }
+  cout << "aag " << m << " " << in << " 0 " << po.size() << " " 
+       << fanin.size() / 2 << "\n";
+  for ( size_t i = 1 ; i <= in ; ++i ) cout << 2 * i << "\n";
+  for ( size_t o = 0 ; o < po.size() ; ++o ) cout << po[ o ] << "\n";
+  for ( size_t k = 0 ; k < fanin.size() / 2 ; ++k )
+    cout << 2 * ( in + 1 + k ) << " " << fanin[ 2 * k ] << " " 
+         << fanin[ 2 * k + 1 ] << "\n";
+}
+
+// pattern n: n random patterns for 16 PIs
+static void
+genPattern( size_t n )
+{
+  for ( size_t k = 0 ; k < n ; ++k ) {
+    for ( size_t i = 0 ; i < 16 ; ++i ) cout << rnd( 2 );
+    cout << "\n";
+  }
+}
+
+// Usage: cirGen <chain | fanout | random | wide | minterm | pattern> <n> [seed]
+int
+main( int argc, char** argv )
+{
+  if ( argc != 3 && argc != 4 ) {
+    cerr << "Usage: cirGen <chain | fanout | random | wide | minterm | "
+         << "pattern> <n> [seed]" << endl;
+    return 1;
+  }
+  string mode = argv[ 1 ];
+  size_t n = strtoul( argv[ 2 ], 0, 10 );
+  if ( argc == 4 ) seed = strtoull( argv[ 3 ], 0, 10 );
+  if ( mode == "chain" ) genChain( n );
+  else if ( mode == "fanout" ) genFanout( n );
+  else if ( mode == "random" ) genRandom( n );
+  else if ( mode == "wide" ) genWide( n );
+  else if ( mode == "minterm" ) genMinterm( n );
+  else if ( mode == "pattern" ) genPattern( n );
+  else {
+    cerr << "Error: unknown circuit \"" << mode << "\"" << endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,11 @@
+#!/bin/sh
+# dfsCheck.sh [fraig] : read and write a 1M-level AND chain with the
+# default stack, which a recursive DFS overflows.
+fraig=${1:-../../../bin/fraig}
+[ -f chain1m.aag ] || ./cirGen chain 1000000 > chain1m.aag
+printf "cirr chain1m.aag\ncirw 500000 -o chain.out\nq -f\n" | \
+  $fraig > /dev/null 2>&1
+if [ $? -eq 0 ] && [ `grep -c "^[0-9]* [0-9]* [0-9]*$" chain.out` -eq 499998 ]
+then echo "ok: dfs"
+else echo "FAIL: dfs"; exit 1
+fi
@@ -0,0 +1,33 @@
+#!/bin/sh
+# fraigCheck.sh [fraig] : fraig a cirGen minterm circuit on 4 simulation
+# threads. One group gives fraig over 512 SAT patterns to resimulate at
+# once, more than a block of CIR_SIM_WORDS <= 8 words, and the other
+# groups keep a cone of less than half the netlist. Afterwards the value
+# of every AIG in the netlist must still be the AND of its fanin values.
+fraig=${1:-../../../bin/fraig}
+[ -f minterm.aag ] || ./cirGen minterm 1100 > minterm.aag
+m=`head -1 minterm.aag | cut -d " " -f 2`
+{ printf "cirr minterm.aag\ncirstr\ncirsim -r -Threads 4\ncirf\ncirp -n\n"
+  awk -v m=$m 'BEGIN { for ( i = 0 ; i <= m ; ++i ) print "cirg " i }'
+  printf "q -f\n"; } | $fraig 2>&1 | awk '
+  /^\[[0-9]+\] AIG / { g = $3; aig[ g ] = 1
+    for ( k = 0 ; k < 2 ; ++k ) {
+      f = $( 4 + k ); inv[ g, k ] = substr( f, 1, 1 ) == "!"
+      sub( "!", "", f ); fi[ g, k ] = f
+    } }
+  /^= [A-Z]+\([0-9]+\)/ { split( $2, s, "[()]" ); id = s[ 2 ] }
+  /^= Value: / { v = $3; gsub( "_", "", v ); val[ id ] = v }
+  END {
+    n = 0; bad = 0
+    for ( g in aig ) {
+      ++n; a = val[ fi[ g, 0 ] ]; b = val[ fi[ g, 1 ] ]; r = ""
+      for ( j = 1 ; j <= 32 ; ++j ) {
+        x = ( substr( a, j, 1 ) == "1" ) != inv[ g, 0 ]
+        y = ( substr( b, j, 1 ) == "1" ) != inv[ g, 1 ]
+        r = r ( x && y ? "1" : "0" )
+      }
+      if ( r != val[ g ] ) ++bad
+    }
+    if ( n > 9000 && bad == 0 ) print "ok: fraig"
+    else { print "FAIL: fraig (" bad " of " n " AIGs)"; exit 1 }
+  }'
@@ -0,0 +1,16 @@
+#!/bin/sh
+# simCheck.sh [fraig] [words] : file simulation of a cirGen circuit must
+# give the FEC groups, values and log in sim<words>.golden. A build with
+# -DCIR_SIM_WORDS=n has its own golden file: FEC groups are split on all
+# n words at once, so their order depends on n. words is 8 by default.
+fraig=${1:-../../../bin/fraig}
+words=${2:-8}
+[ -f sim.aag ] || ./cirGen random 400 1 > sim.aag
+[ -f sim.pat ] || ./cirGen pattern 1000 2 > sim.pat
+printf "cirr sim.aag\ncirsim -f sim.pat -o sim.log\ncirp -fec\n\
+cirg 100\ncirg 152\ncirg 282\ncirg 414\ncirg 417\nq -f\n" | \
+  $fraig 2>&1 | grep -v "^fraig>\|^$" > sim.out
+echo "log: `cksum < sim.log`" >> sim.out
+if cmp -s sim.out sim$words.golden; then echo "ok: sim$words"
+else echo "FAIL: sim$words"; diff sim.out sim$words.golden | head; exit 1
+fi
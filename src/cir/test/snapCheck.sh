@@ -0,0 +1,25 @@
+#!/bin/sh
+# snapCheck.sh [fraig] : a snapshot of snap.aag loads back to the same
+# netlist and FEC groups, and every corruption made by snapEdit is
+# rejected.
+fraig=${1:-../../../bin/fraig}
+fail=0
+
+run() { printf "$1\nq -f\n" | $fraig 2>&1 | grep -v "^fraig>\|^$"; }
+
+run "cirr snap.aag\ncirsim -r\ncirsa snap.snp\ncirp -n\ncirp -fec\ncirg 6" \
+  | grep -v "patterns simulated\|blocks: FEC groups" > snap.out
+run "cirl snap.snp\ncirp -n\ncirp -fec\ncirg 6" > snapLoad.out
+if ! cmp -s snap.out snapLoad.out; then
+  echo "FAIL: snap.snp does not load back"; fail=1
+fi
+
+for e in pi-type net-order aig-fanin drop-pi fec-wrap; do
+  ./snapEdit snap.snp bad.snp $e || { fail=1; continue; }
+  if run "cirl bad.snp" | grep -q "is not a valid snapshot"; then
+    echo "ok: $e"
+  else
+    echo "FAIL: $e is loaded"; fail=1
+  fi
+done
+exit $fail
@@ -0,0 +1,90 @@
+/****************************************************************************
+  FileName     [ snapEdit.cpp ]
+  PackageName  [ cir/test ]
+  Synopsis     [ Corrupt a CIRSAve snapshot in one known way ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2012-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <cstring>
+#include <algorithm>
+
+using namespace std;
+
+// Header fields after the 8-byte magic, in the order of CirSnapHeader
+enum SnapField
+{
+   VERSION, ENDIAN, CMD_STATE, MAX_VARIABLES, TOTAL_SIZE, GATE_NUM,
+   PI_NUM, PO_NUM, NET_NUM, FANOUT_NUM, FEC_GRP_NUM, FEC_MEMBER_NUM,
+   SYMBOL_SIZE, SIM_WORDS, SIM_WORD,
+
+   FIELD_NUM
+};
+
+static const unsigned NoFanin = ~0u;
+static const unsigned AigGate = 3;
+
+static string buf;
+
+static unsigned*
+field() { return ( unsigned* )( &buf[ 8 ] ); }
+
+// the k-th unsigned array after the sim words
+static unsigned*
+array( size_t k ) {
+  unsigned* h = field();
+  size_t n = h[ GATE_NUM ], w = h[ SIM_WORDS ] ? h[ SIM_WORDS ] : 1;
+  size_t skip[] = { n, n, n, n, n, n + 1, h[ FANOUT_NUM ], 
+                    h[ PI_NUM ], h[ PO_NUM ], h[ NET_NUM ] };
+  size_t off = 8 + 4 * FIELD_NUM + 8 * n * w;
+  for ( size_t i = 0 ; i < k ; ++i ) off += 4 * skip[ i ];
+  return ( unsigned* )( &buf[ off ] );
+}
+
+enum SnapArray { ID, TYPE, LINE, FANIN0, FANIN1, FANOUT_BEGIN, FANOUT, 
+                 PI, PO, NET };
+
+// Usage: snapEdit <in.snp> <out.snp> <edit>
+int
+main( int argc, char** argv )
+{
+  if ( argc != 4 ) {
+    cerr << "Usage: snapEdit <in.snp> <out.snp> "
+         << "<pi-type | net-order | aig-fanin | drop-pi | fec-wrap>" << endl;
+    return 1;
+  }
+  ifstream ifs( argv[ 1 ], ios::binary );
+  stringstream ss; ss << ifs.rdbuf(); buf = ss.str();
+  if ( buf.size() < 8 + 4 * FIELD_NUM ) {
+    cerr << "Error: " << argv[ 1 ] << " is too short" << endl;
+    return 1;
+  }
+  unsigned* h = field();
+  string edit = argv[ 3 ];
+  if ( edit == "pi-type" )          // a PO in the PI list
+    array( PI )[ 0 ] = array( PO )[ 0 ];
+  else if ( edit == "net-order" )   // every gate before its fanins
+    reverse( array( NET ), array( NET ) + h[ NET_NUM ] );
+  else if ( edit == "aig-fanin" ) { // an AIG with one fanin
+    for ( size_t i = 0 ; i < h[ GATE_NUM ] ; ++i )
+      if ( array( TYPE )[ i ] == AigGate ) 
+        { array( FANIN1 )[ i ] = NoFanin; break; }
+  }
+  else if ( edit == "drop-pi" ) {   // PI array gone, count out of range
+    buf.erase( ( char* )array( PI ) - &buf[ 0 ], 4 * h[ PI_NUM ] );
+    field()[ PI_NUM ] = 0x3FFFFFFF;
+  }
+  else if ( edit == "fec-wrap" )    // fecGrpNum + 1 wraps to 0
+    h[ FEC_GRP_NUM ] = ~0u;
+  else {
+    cerr << "Error: unknown edit \"" << edit << "\"" << endl;
+    return 1;
+  }
+  ofstream ofs( argv[ 2 ], ios::binary );
+  ofs.write( buf.data(), buf.size() );
+  return ofs ? 0 : 1;
+}
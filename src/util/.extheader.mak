@@ -1,4 +1,4 @@
-util.d: ../../include/util.h ../../include/rnGen.h ../../include/myUsage.h ../../include/myHashMap.h 
+util.d: ../../include/util.h ../../include/rnGen.h ../../include/myUsage.h ../../include/myHashMap.h ../../include/myFile.h ../../include/myThread.h ../../include/myArena.h 
 ../../include/util.h: util.h
 	@rm -f ../../include/util.h
 	@ln -fs ../src/util/util.h ../../include/util.h
@@ -11,3 +11,12 @@ util.d: ../../include/util.h ../../include/rnGen.h ../../include/myUsage.h ../..
 ../../include/myHashMap.h: myHashMap.h
 	@rm -f ../../include/myHashMap.h
 	@ln -fs ../src/util/myHashMap.h ../../include/myHashMap.h
+../../include/myFile.h: myFile.h
+	@rm -f ../../include/myFile.h
+	@ln -fs ../src/util/myFile.h ../../include/myFile.h
+../../include/myThread.h: myThread.h
+	@rm -f ../../include/myThread.h
+	@ln -fs ../src/util/myThread.h ../../include/myThread.h
+../../include/myArena.h: myArena.h
+	@rm -f ../../include/myArena.h
+	@ln -fs ../src/util/myArena.h ../../include/myArena.h
@@ -0,0 +1,78 @@
+/****************************************************************************
+  FileName     [ myArena.h ]
+  PackageName  [ util ]
+  Synopsis     [ Fixed-size slot allocator with a free list ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2007-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef MY_ARENA_H
+#define MY_ARENA_H
+
+#include <vector>
+#include <cstdlib>
+#include <new>
+
+using namespace std;
+
+// Slots of one size are carved out of large blocks. free() puts a slot on
+// a free list that alloc() takes from first. release() gives back all the
+// blocks at once and never runs any destructor; the objects in the slots
+// must have been destroyed, or not need it, by then.
+class MyArena
+{
+public:
+   MyArena(size_t slotSize, size_t blockSlots = 1 << 14)
+   : _slotSize((slotSize + 7) & ~size_t(7)), _blockSlots(blockSlots),
+     _cur(0), _end(0), _freeList(0) {
+      if (_slotSize < sizeof(void*)) _slotSize = sizeof(void*);
+   }
+   ~MyArena() { release(); }
+
+   void* alloc() {
+      if (_freeList) {
+         void* p = _freeList;
+         _freeList = *(void**)p;
+         return p;
+      }
+      if (_cur == _end) {
+         _cur = newBlock(_blockSlots);
+         _end = _cur + _slotSize * _blockSlots;
+      }
+      void* p = _cur;
+      _cur += _slotSize;
+      return p;
+   }
+   void free(void* p) {
+      *(void**)p = _freeList;
+      _freeList = p;
+   }
+   // n contiguous slots in a block of their own, e.g. to be filled by
+   // several threads; slots left unused are given back by release()
+   char* allocBlock(size_t n) { return n? newBlock(n): 0; }
+   void release() {
+      for (size_t i = 0, n = _blocks.size(); i < n; ++i)
+         std::free(_blocks[i]);
+      vector<char*>().swap(_blocks);
+      _cur = _end = 0; _freeList = 0;
+   }
+
+   size_t slotSize() const { return _slotSize; }
+
+private:
+   size_t           _slotSize;
+   size_t           _blockSlots;
+   vector<char*>    _blocks;
+   char*            _cur;
+   char*            _end;
+   void*            _freeList;
+
+   char* newBlock(size_t n) {
+      char* b = (char*)malloc(_slotSize * n);
+      if (!b) throw std::bad_alloc();
+      _blocks.push_back(b);
+      return b;
+   }
+};
+
+#endif // MY_ARENA_H
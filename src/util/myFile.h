@@ -0,0 +1,77 @@
+/****************************************************************************
+  FileName     [ myFile.h ]
+  PackageName  [ util ]
+  Synopsis     [ Read-only memory-mapped file ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2007-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef MY_FILE_H
+#define MY_FILE_H
+
+#include <string>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+
+// The whole file is mapped at open(); the bytes in [begin(), end()) stay
+// valid until close(). Files that cannot be mapped (e.g. pipes) are read
+// into a heap buffer instead.
+class MyMappedFile
+{
+public:
+   MyMappedFile() : _data(0), _size(0), _mapped(false) {}
+   ~MyMappedFile() { close(); }
+
+   bool open(const string& fileName) {
+      close();
+      int fd = ::open(fileName.c_str(), O_RDONLY);
+      if (fd < 0) return false;
+      struct stat st;
+      if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+         void* p = mmap(0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+         if (p != MAP_FAILED) {
+            _data = (char*)p; _size = st.st_size; _mapped = true;
+            madvise(p, _size, MADV_SEQUENTIAL);
+            ::close(fd);
+            return true;
+         }
+      }
+      bool ok = readAll(fd);
+      ::close(fd);
+      return ok;
+   }
+   void close() {
+      if (_mapped) munmap(_data, _size);
+      else delete [] _data;
+      _data = 0; _size = 0; _mapped = false;
+   }
+
+   const char* begin() const { return _data; }
+   const char* end() const { return _data + _size; }
+   size_t size() const { return _size; }
+
+private:
+   char*      _data;
+   size_t     _size;
+   bool       _mapped;
+
+   bool readAll(int fd) {
+      size_t cap = 1 << 16;
+      _data = new char[cap];
+      for (ssize_t n; (n = ::read(fd, _data + _size, cap - _size)) != 0; ) {
+         if (n < 0) { close(); return false; }
+         if ((_size += n) == cap) {
+            char* buf = new char[cap *= 2];
+            for (size_t i = 0; i < _size; ++i) buf[i] = _data[i];
+            delete [] _data; _data = buf;
+         }
+      }
+      return true;
+   }
+};
+
+#endif // MY_FILE_H
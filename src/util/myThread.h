@@ -0,0 +1,74 @@
+/****************************************************************************
+  FileName     [ myThread.h ]
+  PackageName  [ util ]
+  Synopsis     [ Run member functions on a group of POSIX threads ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2007-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef MY_THREAD_H
+#define MY_THREAD_H
+
+#include <vector>
+#include <pthread.h>
+#include <unistd.h>
+
+using namespace std;
+
+// Bound on the threads of one parallel run; set it with -DMY_MAX_THREADS=n.
+// Within it, CirMgr::simulate() measures the fastest count at run time,
+// and src/cir/test/benchThreads.sh reports the scaling of a build.
+#ifndef MY_MAX_THREADS
+#define MY_MAX_THREADS 32
+#endif
+
+// number of online cores, at most MY_MAX_THREADS
+inline size_t myNumThreads()
+{
+   long n = sysconf(_SC_NPROCESSORS_ONLN);
+   if (n < 1) return 1;
+   return (n > MY_MAX_THREADS)? MY_MAX_THREADS: size_t(n);
+}
+
+template <class T, class A>
+class MyThreadJob
+{
+public:
+   typedef void (T::*Func)(A&, size_t);
+
+   MyThreadJob(T* o = 0, Func f = 0, A* a = 0, size_t i = 0)
+   : _obj(o), _func(f), _arg(a), _id(i) {}
+
+   void run() { (_obj->*_func)(*_arg, _id); }
+   static void* entry(void* job) {
+      static_cast<MyThreadJob*>(job)->run(); return 0; }
+
+private:
+   T*        _obj;
+   Func      _func;
+   A*        _arg;
+   size_t    _id;
+};
+
+// Call (obj->*func)(arg, i) for i = 0 ~ n-1, each on its own thread, and
+// return when all of them are done. i = 0 runs on the calling thread; if a
+// thread cannot be created, its share also runs on the calling thread.
+template <class T, class A>
+void myParallelRun(T* obj, void (T::*func)(A&, size_t), A& arg, size_t n)
+{
+   vector<MyThreadJob<T, A> > jobs;
+   vector<pthread_t> tids(n);
+   vector<bool> created(n, false);
+   for (size_t i = 0; i < n; ++i)
+      jobs.push_back(MyThreadJob<T, A>(obj, func, &arg, i));
+   for (size_t i = 1; i < n; ++i)
+      created[i] = (pthread_create(&tids[i], 0, MyThreadJob<T, A>::entry,
+                                   &jobs[i]) == 0);
+   jobs[0].run();
+   for (size_t i = 1; i < n; ++i) {
+      if (created[i]) pthread_join(tids[i], 0);
+      else jobs[i].run();
+   }
+}
+
+#endif // MY_THREAD_H
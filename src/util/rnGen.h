@@ -26,5 +26,38 @@ class RandomNumGen
       }
 };
 
+// xoshiro256** on a state seeded by SplitMix64: 64 random bits a call.
+// Generators of the same seed and different streams are independent, so
+// each thread or block can take its own one reproducibly.
+class RandomWordGen
+{
+   public:
+      RandomWordGen(unsigned long long seed = 0,
+                    unsigned long long stream = 0) {
+         unsigned long long x = seed;
+         x = splitMix(x) ^ stream;
+         for (int i = 0; i < 4; ++i) _s[i] = splitMix(x);
+      }
+      unsigned long long operator() () {
+         unsigned long long r = rotl(_s[1] * 5, 7) * 9, t = _s[1] << 17;
+         _s[2] ^= _s[0]; _s[3] ^= _s[1]; _s[1] ^= _s[2]; _s[0] ^= _s[3];
+         _s[2] ^= t; _s[3] = rotl(_s[3], 45);
+         return r;
+      }
+
+   private:
+      unsigned long long _s[4];
+
+      static unsigned long long rotl(unsigned long long x, int k) {
+         return (x << k) | (x >> (64 - k));
+      }
+      static unsigned long long splitMix(unsigned long long& x) {
+         unsigned long long z = (x += 0x9E3779B97F4A7C15ULL);
+         z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+         z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+         return z ^ (z >> 31);
+      }
+};
+
 #endif // RN_GEN_H
 